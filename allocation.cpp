@@ -0,0 +1,59 @@
+#include "allocation.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef TRACK_ALLOCATIONS
+
+static std::atomic<uint64_t> allocations{0};
+
+static void* countedAlloc(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+static void* countedAlignedAlloc(std::size_t size, std::align_val_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    std::size_t align = static_cast<std::size_t>(alignment);
+    return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+void* operator new(std::size_t size) {
+    void* p = countedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](std::size_t size) {
+    void* p = countedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    void* p = countedAlignedAlloc(size, alignment);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    void* p = countedAlignedAlloc(size, alignment);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+uint64_t allocationCount() { return allocations.load(std::memory_order_relaxed); }
+
+#else
+
+uint64_t allocationCount() { return 0; }
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef ALLOCATION_H
+#define ALLOCATION_H
+
+#include <cstdint>
+
+// Heap allocation counting. A build with TRACK_ALLOCATIONS (make TRACK_ALLOCATIONS=1)
+// replaces the global operator new with a version that counts every call; otherwise
+// nothing is replaced and the count stays 0.
+#ifdef TRACK_ALLOCATIONS
+const bool ALLOCATION_TRACKING = true;
+#else
+const bool ALLOCATION_TRACKING = false;
+#endif
+
+// Allocations made since the program started
+uint64_t allocationCount();
+
+#endif // ALLOCATION_H
@@ -0,0 +1,220 @@
+#include "attacks.h"
+#include "board.h"
+
+// The tables are generated at compile time and live in read-only data: nothing is built at startup
+
+static constexpr int KNIGHT_DELTAS[8][2] = {{-2,-1},{-2,1},{-1,-2},{-1,2},{1,-2},{1,2},{2,-1},{2,1}};
+// Ray directions (row, col). The first four increase the square index (the nearest blocker
+// is the lowest bit), the last four decrease it; direction d + 4 is opposite to d.
+static constexpr int RAY_DIRS[8][2] = {{0,1},{1,0},{1,1},{1,-1},{0,-1},{-1,0},{-1,-1},{-1,1}};
+
+static constexpr bool onBoard(int r, int c) { return r >= 0 && r < 8 && c >= 0 && c < 8; }
+
+// Squares one step away along each delta
+static constexpr std::array<Bitboard, 64> makeStepAttacks(const int (&deltas)[8][2]) {
+    std::array<Bitboard, 64> table{};
+    for (int sq = 0; sq < 64; sq++) {
+        for (int d = 0; d < 8; d++) {
+            int r = sq / 8 + deltas[d][0], c = sq % 8 + deltas[d][1];
+            if (onBoard(r, c)) table[sq] |= squareBB(r * 8 + c);
+        }
+    }
+    return table;
+}
+
+static constexpr std::array<std::array<Bitboard, 64>, 2> makePawnAttacks() {
+    std::array<std::array<Bitboard, 64>, 2> table{};
+    for (int sq = 0; sq < 64; sq++) {
+        // White pawns attack towards row 0
+        table[0][sq] = shiftNorth(shiftEast(squareBB(sq)) | shiftWest(squareBB(sq)));
+        table[1][sq] = shiftSouth(shiftEast(squareBB(sq)) | shiftWest(squareBB(sq)));
+    }
+    return table;
+}
+
+// Rays from each square to the board edge
+static constexpr std::array<std::array<Bitboard, 64>, 8> makeRays() {
+    std::array<std::array<Bitboard, 64>, 8> table{};
+    for (int d = 0; d < 8; d++) {
+        for (int sq = 0; sq < 64; sq++) {
+            for (int r = sq / 8 + RAY_DIRS[d][0], c = sq % 8 + RAY_DIRS[d][1]; onBoard(r, c);
+                 r += RAY_DIRS[d][0], c += RAY_DIRS[d][1]) {
+                table[d][sq] |= squareBB(r * 8 + c);
+            }
+        }
+    }
+    return table;
+}
+
+static constexpr std::array<std::array<Bitboard, 64>, 8> rayBB = makeRays();
+
+// Between (line == false) or line (line == true) table: walk each ray from 'a'
+static constexpr std::array<std::array<Bitboard, 64>, 64> makeLineTable(bool line) {
+    std::array<std::array<Bitboard, 64>, 64> table{};
+    for (int a = 0; a < 64; a++) {
+        for (int d = 0; d < 8; d++) {
+            Bitboard between = 0;
+            for (int r = a / 8 + RAY_DIRS[d][0], c = a % 8 + RAY_DIRS[d][1]; onBoard(r, c);
+                 r += RAY_DIRS[d][0], c += RAY_DIRS[d][1]) {
+                int b = r * 8 + c;
+                table[a][b] = line ? rayBB[d][a] | rayBB[(d + 4) % 8][a] | squareBB(a) : between;
+                between |= squareBB(b);
+            }
+        }
+    }
+    return table;
+}
+
+static constexpr std::array<std::array<uint8_t, 64>, 64> makeDistances() {
+    std::array<std::array<uint8_t, 64>, 64> table{};
+    for (int a = 0; a < 64; a++) {
+        for (int b = 0; b < 64; b++) {
+            int dr = a / 8 - b / 8, dc = a % 8 - b % 8;
+            dr = dr < 0 ? -dr : dr; dc = dc < 0 ? -dc : dc;
+            table[a][b] = (uint8_t)(dr > dc ? dr : dc);
+        }
+    }
+    return table;
+}
+
+constexpr std::array<Bitboard, 64> knightAttacksBB = makeStepAttacks(KNIGHT_DELTAS);
+constexpr std::array<Bitboard, 64> kingAttacksBB = makeStepAttacks(RAY_DIRS);
+constexpr std::array<std::array<Bitboard, 64>, 2> pawnAttacksBB = makePawnAttacks();
+constexpr std::array<std::array<Bitboard, 64>, 64> betweenBB = makeLineTable(false);
+constexpr std::array<std::array<Bitboard, 64>, 64> lineBB = makeLineTable(true);
+constexpr std::array<std::array<uint8_t, 64>, 64> squareDistance = makeDistances();
+
+// Squares along one ray up to and including the first blocker
+static Bitboard rayAttacks(int dir, int sq, Bitboard occupied) {
+    Bitboard ray = rayBB[dir][sq], blockers = ray & occupied;
+    if (!blockers) return ray;
+    int first = dir < 4 ? lsbIndex(blockers) : msbIndex(blockers);
+    return ray & ~rayBB[dir][first];
+}
+
+Bitboard bishopAttacks(int sq, Bitboard occupied) {
+    return rayAttacks(2, sq, occupied) | rayAttacks(3, sq, occupied) | rayAttacks(6, sq, occupied) | rayAttacks(7, sq, occupied);
+}
+
+Bitboard rookAttacks(int sq, Bitboard occupied) {
+    return rayAttacks(0, sq, occupied) | rayAttacks(1, sq, occupied) | rayAttacks(4, sq, occupied) | rayAttacks(5, sq, occupied);
+}
+
+Bitboard pieceAttacksBB(int piece, int sq, Bitboard occupied) {
+    switch (piece % 6) {
+        case 0: return pawnAttacksBB[piece / 6][sq];
+        case 1: return knightAttacksBB[sq];
+        case 2: return bishopAttacks(sq, occupied);
+        case 3: return rookAttacks(sq, occupied);
+        case 4: return bishopAttacks(sq, occupied) | rookAttacks(sq, occupied);
+        default: return kingAttacksBB[sq];
+    }
+}
+
+Bitboard attackersTo(const BoardState& state, int sq, Bitboard occupied) {
+    const Bitboard* bb = state.pieceBB;
+    return (pawnAttacksBB[1][sq] & bb[0]) | (pawnAttacksBB[0][sq] & bb[6]) |
+           (knightAttacksBB[sq] & (bb[1] | bb[7])) |
+           (kingAttacksBB[sq] & (bb[5] | bb[11])) |
+           (bishopAttacks(sq, occupied) & (bb[2] | bb[8] | bb[4] | bb[10])) |
+           (rookAttacks(sq, occupied) & (bb[3] | bb[9] | bb[4] | bb[10]));
+}
+
+// Pieces standing alone between a side's king and an enemy slider
+static Bitboard sliderBlockers(const BoardState& state, int side, Bitboard occupied) {
+    Bitboard kingBB = state.pieceBB[side * 6 + 5];
+    if (!kingBB) return 0;
+    int ksq = lsbIndex(kingBB), enemy = (side ^ 1) * 6;
+    Bitboard snipers = (rookAttacks(ksq, 0) & (state.pieceBB[enemy + 3] | state.pieceBB[enemy + 4])) |
+                       (bishopAttacks(ksq, 0) & (state.pieceBB[enemy + 2] | state.pieceBB[enemy + 4]));
+    Bitboard blockers = 0;
+    while (snipers) {
+        Bitboard between = betweenBB[ksq][popLsb(snipers)] & occupied;
+        if (between && !(between & (between - 1))) blockers |= between;
+    }
+    return blockers;
+}
+
+void computeAttackInfo(const BoardState& state, AttackInfo& info) {
+    Bitboard occupied = state.occupancy[0] | state.occupancy[1];
+    for (int side = 0; side < 2; side++) {
+        info.bySide[side] = info.doubleAttacks[side] = 0;
+        for (int type = 0; type < 6; type++) {
+            int piece = side * 6 + type;
+            Bitboard typeAttacks = 0;
+            if (type == 0) {
+                // Pawns set-wise; doubled pawn attacks count as double attacks
+                Bitboard pawns = state.pieceBB[piece];
+                Bitboard east = side == 0 ? shiftNorth(shiftEast(pawns)) : shiftSouth(shiftEast(pawns));
+                Bitboard west = side == 0 ? shiftNorth(shiftWest(pawns)) : shiftSouth(shiftWest(pawns));
+                info.doubleAttacks[side] |= east & west;
+                typeAttacks = east | west;
+                for (Bitboard b = pawns; b; ) { int sq = popLsb(b); info.attacksFrom[sq] = pawnAttacksBB[side][sq]; }
+            } else {
+                for (Bitboard b = state.pieceBB[piece]; b; ) {
+                    int sq = popLsb(b);
+                    Bitboard attacks = pieceAttacksBB(piece, sq, occupied);
+                    info.attacksFrom[sq] = attacks;
+                    info.doubleAttacks[side] |= typeAttacks & attacks;
+                    typeAttacks |= attacks;
+                }
+            }
+            info.doubleAttacks[side] |= info.bySide[side] & typeAttacks;
+            info.bySide[side] |= typeAttacks;
+            info.byType[side][type] = typeAttacks;
+        }
+    }
+    int us = state.whiteToMove ? 0 : 1;
+    Bitboard kingBB = state.pieceBB[us * 6 + 5];
+    info.checkers = kingBB ? attackersTo(state, lsbIndex(kingBB), occupied) & state.occupancy[us ^ 1] : 0;
+    info.kingBlockers[0] = sliderBlockers(state, 0, occupied);
+    info.kingBlockers[1] = sliderBlockers(state, 1, occupied);
+
+    Bitboard enemyKing = state.pieceBB[(us ^ 1) * 6 + 5];
+    if (!enemyKing) {
+        for (int type = 0; type < 6; type++) info.checkSquares[type] = 0;
+        return;
+    }
+    int ksq = lsbIndex(enemyKing);
+    info.checkSquares[0] = pawnAttacksBB[us ^ 1][ksq];
+    info.checkSquares[1] = knightAttacksBB[ksq];
+    info.checkSquares[2] = bishopAttacks(ksq, occupied);
+    info.checkSquares[3] = rookAttacks(ksq, occupied);
+    info.checkSquares[4] = info.checkSquares[2] | info.checkSquares[3];
+    info.checkSquares[5] = 0;
+}
+
+bool givesCheck(const BoardState& state, const AttackInfo& info, const Move& move) {
+    int us = state.whiteToMove ? 0 : 1;
+    Bitboard enemyKing = state.pieceBB[(us ^ 1) * 6 + 5];
+    if (!enemyKing) return false;
+    int ksq = lsbIndex(enemyKing);
+    int from = move.fromRow * 8 + move.fromCol, to = move.toRow * 8 + move.toCol;
+    int piece = pieceIndex(state.board[move.fromRow][move.fromCol]);
+
+    // Direct check
+    if (move.promotionPiece == EMPTY && (info.checkSquares[piece % 6] & squareBB(to))) return true;
+
+    // Discovered check: a blocker of the enemy king leaves the line
+    if ((info.kingBlockers[us ^ 1] & state.occupancy[us] & squareBB(from)) && !(lineBB[ksq][from] & squareBB(to))) return true;
+
+    if (move.promotionPiece == EMPTY && !move.isEnPassantCapture && !move.isKingSideCastle && !move.isQueenSideCastle) return false;
+
+    Bitboard occupied = (state.occupancy[0] | state.occupancy[1]) ^ squareBB(from);
+    if (move.promotionPiece != EMPTY) {
+        return (pieceAttacksBB(pieceIndex(move.promotionPiece), to, occupied | squareBB(to)) & enemyKing) != 0;
+    }
+    if (move.isEnPassantCapture) {
+        // The captured pawn may uncover a slider
+        int capturedSquare = us == 0 ? to + 8 : to - 8;
+        occupied = (occupied ^ squareBB(capturedSquare)) | squareBB(to);
+        Bitboard queens = state.pieceBB[us * 6 + 4];
+        return ((rookAttacks(ksq, occupied) & (state.pieceBB[us * 6 + 3] | queens)) |
+                (bishopAttacks(ksq, occupied) & (state.pieceBB[us * 6 + 2] | queens))) != 0;
+    }
+    // Castling: the rook lands next to the king
+    int rookFrom = move.isKingSideCastle ? from + 3 : from - 4;
+    int rookTo = move.isKingSideCastle ? from + 1 : from - 1;
+    occupied = (occupied ^ squareBB(rookFrom)) | squareBB(to) | squareBB(rookTo);
+    return (rookAttacks(rookTo, occupied) & enemyKing) != 0;
+}
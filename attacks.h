@@ -0,0 +1,50 @@
+#ifndef ATTACKS_H
+#define ATTACKS_H
+
+#include "types.h"
+#include "bitboard.h"
+#include <array>
+
+// Attack tables and per-node attack information from the piece bitboards.
+// Side 0 is white, 1 black; piece types are pieceIndex % 6 (P, N, B, R, Q, K).
+
+// Tables are generated at compile time (constexpr, see attacks.cpp)
+extern const std::array<Bitboard, 64> knightAttacksBB;
+extern const std::array<Bitboard, 64> kingAttacksBB;
+extern const std::array<std::array<Bitboard, 64>, 2> pawnAttacksBB;  // Squares a pawn of that side attacks
+extern const std::array<std::array<Bitboard, 64>, 64> betweenBB;     // Squares strictly between two aligned squares, 0 otherwise
+extern const std::array<std::array<Bitboard, 64>, 64> lineBB;        // Whole line through two aligned squares, 0 otherwise
+extern const std::array<std::array<uint8_t, 64>, 64> squareDistance; // King steps between two squares
+
+// Slider attacks for a given occupancy
+Bitboard bishopAttacks(int sq, Bitboard occupied);
+Bitboard rookAttacks(int sq, Bitboard occupied);
+
+// Attacks of a piece (pieceIndex 0-11) standing on 'sq'
+Bitboard pieceAttacksBB(int piece, int sq, Bitboard occupied);
+
+// Pieces of both sides attacking 'sq' with the given occupancy
+Bitboard attackersTo(const BoardState& state, int sq, Bitboard occupied);
+
+inline int kingSquare(const BoardState& state, int side) { return lsbIndex(state.pieceBB[side * 6 + 5]); }
+
+// Attack information for one position. It is computed once per node and shared by the
+// evaluation (mobility, king safety) and legal move generation.
+struct AttackInfo {
+    Bitboard attacksFrom[64];      // Squares attacked by the piece on each square
+    Bitboard byType[2][6];         // Union of the attacks per side and piece type
+    Bitboard bySide[2];            // All squares attacked by a side
+    Bitboard doubleAttacks[2];     // Squares attacked at least twice by a side
+    Bitboard checkers;             // Pieces giving check to the side to move
+    Bitboard kingBlockers[2];      // Pieces (either side) that alone shield a side's king from a slider
+    Bitboard checkSquares[6];      // Squares where a piece of the side to move, by type, would check
+};
+
+void computeAttackInfo(const BoardState& state, AttackInfo& info);
+
+// Whether a legal move of the side to move gives check, without making it: direct checks
+// from checkSquares, discovered checks from the enemy king's blockers, and the rook of a
+// castling move, promotions and en passant handled on the board after the move
+bool givesCheck(const BoardState& state, const AttackInfo& info, const Move& move);
+
+#endif // ATTACKS_H
@@ -0,0 +1,100 @@
+#include "bench.h"
+#include "search.h"
+#include "movegen.h"
+#include "board.h"
+#include "tt.h"
+#include "allocation.h"
+#include "profile.h"
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <string>
+
+static const char* const BENCH_POSITIONS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r1bqkbnr/1ppp1ppp/p1n5/1B2p3/4P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 0 4",
+    "rnbqk2r/ppp1bppp/4pn2/3p2B1/2PP4/2N5/PP2PPPP/R2QKBNR w KQkq - 4 5",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bq1rk1/pp2nppp/2n1p3/3pP3/1b1P4/2NB1N2/PP3PPP/R1BQK2R b KQ - 3 9",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "8/8/4k3/3p4/3P4/4K3/8/8 w - - 0 1",
+};
+
+struct BenchResult {
+    uint64_t nodes;
+    uint64_t allocations; // Inside searchRoot only
+    Move bestMove;
+};
+
+// Iterative deepening to 'depth' on one position, as handleGo does without the time limit
+static BenchResult searchPosition(const std::string& fen, int depth) {
+    BenchResult result = {0, 0, Move()};
+    BoardState root;
+    root.parseFen(fen);
+    gameHistory.assign(1, root.hashKey);
+    MoveList rootMoves, bestMoves;
+    generateLegalMoves(root, rootMoves, false);
+    if (rootMoves.empty()) return result;
+    orderMoves(root, rootMoves, 0);
+
+    time_is_up.store(false, std::memory_order_relaxed);
+    nodes_searched.store(0, std::memory_order_relaxed);
+    transpositionTable.newSearch();
+    clearKillerMoves();
+    auto startTime = std::chrono::steady_clock::now();
+    std::chrono::milliseconds timeLimit = std::chrono::hours(24);
+
+    int score = std::numeric_limits<int>::min();
+    for (int d = 1; d <= depth; ++d) {
+        uint64_t allocationsBefore = allocationCount();
+        score = searchRoot(root, rootMoves, d, score, startTime, timeLimit, bestMoves);
+        result.allocations += allocationCount() - allocationsBefore;
+        if (!bestMoves.empty()) result.bestMove = bestMoves[0];
+    }
+    result.nodes = nodes_searched.load(std::memory_order_relaxed);
+    return result;
+}
+
+bool runBench(int depth, bool checkAllocations) {
+    if (checkAllocations && !ALLOCATION_TRACKING) {
+        std::cerr << "bench: --check-alloc needs a build with TRACK_ALLOCATIONS (make clean && make TRACK_ALLOCATIONS=1)" << std::endl;
+        return false;
+    }
+    const int positionCount = sizeof(BENCH_POSITIONS) / sizeof(BENCH_POSITIONS[0]);
+    transpositionTable.clear();
+    clearHistoryTable();
+    if (checkAllocations) {
+        // Warm-up: lazily sized containers reach their working size here
+        for (int i = 0; i < positionCount; ++i) searchPosition(BENCH_POSITIONS[i], depth);
+        transpositionTable.clear();
+        clearHistoryTable();
+    }
+
+    uint64_t totalNodes = 0, totalAllocations = 0;
+    if (profilingEnabled) resetProfile();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < positionCount; ++i) {
+        BenchResult result = searchPosition(BENCH_POSITIONS[i], depth);
+        totalNodes += result.nodes;
+        totalAllocations += result.allocations;
+        std::cout << "Position " << (i + 1) << "/" << positionCount << ": bestmove " << result.bestMove.toUci()
+                  << ", nodes " << result.nodes;
+        if (ALLOCATION_TRACKING) std::cout << ", allocations " << result.allocations;
+        std::cout << std::endl;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Depth: " << depth << std::endl;
+    std::cout << "Nodes searched: " << totalNodes << std::endl;
+    std::cout << "Time (ms): " << elapsed << std::endl;
+    std::cout << "Nodes/second: " << (elapsed > 0 ? totalNodes * 1000 / elapsed : 0) << std::endl;
+    if (ALLOCATION_TRACKING) std::cout << "Heap allocations in search: " << totalAllocations << std::endl;
+    if (profilingEnabled) printProfile("");
+
+    if (checkAllocations && totalAllocations > 0) {
+        std::cerr << "bench: " << totalAllocations << " heap allocations inside the search after warm-up" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,17 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// Fixed-depth benchmark: `chess_engine bench [depth] [--check-alloc] [--profile]` searches a fixed set
+// of positions and reports nodes, time and nodes per second, plus the heap allocations
+// made inside the search in TRACK_ALLOCATIONS builds.
+//
+// With checkAllocations every position is searched once to warm up, then searched again;
+// any allocation during the second pass is reported and fails the run. It needs a
+// TRACK_ALLOCATIONS build. With --profile the measured pass ends with a search phase
+// breakdown (see profile.h).
+const int BENCH_DEFAULT_DEPTH = 5;
+
+// Returns false on a failed allocation check (details on stderr)
+bool runBench(int depth, bool checkAllocations);
+
+#endif // BENCH_H
@@ -0,0 +1,512 @@
+#include "bitbase.h"
+#include "board.h"
+#include "attacks.h"
+#include "constants.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Geometry (square = row * 8 + col, row 0 = rank 8; piece types as pieceIndex % 6)
+static int transformTable[8][64];  // Board symmetries: bit 0 mirrors files, bit 1 rows, bit 2 transposes
+static int triangleIndex[64];      // Index in the a1-d1-d4 triangle, -1 outside it
+static int triangleSquare[10];
+static int kingTransforms[64][2];  // Symmetries taking a king square into the triangle (two on the diagonal)
+static int kingTransformCount[64];
+
+static uint64_t bit(int sq) { return 1ULL << sq; }
+
+static void initGeometry() {
+    static bool initialized = false;
+    if (initialized) return;
+    int triangleCount = 0;
+    for (int sq = 0; sq < 64; ++sq) {
+        int r = sq >> 3, c = sq & 7;
+        for (int t = 0; t < 8; ++t) {
+            int tr = (t & 2) ? 7 - r : r, tc = (t & 1) ? 7 - c : c;
+            if (t & 4) std::swap(tr, tc);
+            transformTable[t][sq] = tr * 8 + tc;
+        }
+        int rank = 7 - r;
+        triangleIndex[sq] = (c <= 3 && rank <= c) ? triangleCount : -1;
+        if (triangleIndex[sq] >= 0) triangleSquare[triangleCount++] = sq;
+    }
+    for (int sq = 0; sq < 64; ++sq) {
+        kingTransformCount[sq] = 0;
+        for (int t = 0; t < 8 && kingTransformCount[sq] < 2; ++t) {
+            if (triangleIndex[transformTable[t][sq]] >= 0) kingTransforms[sq][kingTransformCount[sq]++] = t;
+        }
+    }
+    initialized = true;
+}
+
+static uint64_t pieceAttacks(int type, int sq, uint64_t occupied) {
+    switch (type) {
+        case 1: return knightAttacksBB[sq];
+        case 2: return bishopAttacks(sq, occupied);
+        case 3: return rookAttacks(sq, occupied);
+        case 4: return bishopAttacks(sq, occupied) | rookAttacks(sq, occupied);
+        case 5: return kingAttacksBB[sq];
+        default: return 0;
+    }
+}
+
+// KPK
+
+// Bit set: the side with the pawn wins. Indexed with the pawn on files a-d and moving towards row 0.
+static uint8_t kpkWins[2 * 24 * 64 * 64 / 8];
+static bool kpkReady = false;
+
+// stm 0 = side with the pawn to move
+static int kpkIndex(int stm, int strongKing, int weakKing, int pawn) {
+    int pawnIndex = ((pawn >> 3) - 1) * 4 + (pawn & 7);
+    return ((stm * 24 + pawnIndex) * 64 + strongKing) * 64 + weakKing;
+}
+
+void initKPKBitbase() {
+    if (kpkReady) return;
+    initGeometry();
+    enum { KPK_INVALID, KPK_UNKNOWN, KPK_DRAW, KPK_WIN };
+    const int size = 2 * 24 * 64 * 64;
+    std::vector<uint8_t> result(size);
+
+    for (int idx = 0; idx < size; ++idx) {
+        int weakKing = idx & 63, strongKing = (idx >> 6) & 63;
+        int pawnIndex = (idx >> 12) % 24, stm = (idx >> 12) / 24;
+        int pawn = (pawnIndex / 4 + 1) * 8 + pawnIndex % 4, row = pawn >> 3;
+        uint64_t pawnAttacks = ((pawn & 7) > 0 ? bit(pawn - 9) : 0) | ((pawn & 7) < 7 ? bit(pawn - 7) : 0);
+        int promotion = pawn - 8;
+
+        if (strongKing == weakKing || strongKing == pawn || weakKing == pawn || (kingAttacksBB[strongKing] & bit(weakKing))) {
+            result[idx] = KPK_INVALID;
+        } else if (stm == 0 && (pawnAttacks & bit(weakKing))) {
+            result[idx] = KPK_INVALID; // Defender in check with the attacker to move
+        } else if (stm == 0 && row == 1 && promotion != strongKing && promotion != weakKing &&
+                   (!(kingAttacksBB[weakKing] & bit(promotion)) || (kingAttacksBB[strongKing] & bit(promotion)))) {
+            result[idx] = KPK_WIN;     // Promotes safely
+        } else if (stm == 1 && !(kingAttacksBB[weakKing] & ~kingAttacksBB[strongKing] & ~pawnAttacks)) {
+            result[idx] = KPK_DRAW;    // Stalemate
+        } else if (stm == 1 && (kingAttacksBB[weakKing] & bit(pawn)) && !(kingAttacksBB[strongKing] & bit(pawn))) {
+            result[idx] = KPK_DRAW;    // Takes the pawn
+        } else {
+            result[idx] = KPK_UNKNOWN;
+        }
+    }
+
+    // Resolve positions from their successors until nothing changes
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int idx = 0; idx < size; ++idx) {
+            if (result[idx] != KPK_UNKNOWN) continue;
+            int weakKing = idx & 63, strongKing = (idx >> 6) & 63;
+            int pawnIndex = (idx >> 12) % 24, stm = (idx >> 12) / 24;
+            int pawn = (pawnIndex / 4 + 1) * 8 + pawnIndex % 4, row = pawn >> 3;
+            uint64_t pawnAttacks = ((pawn & 7) > 0 ? bit(pawn - 9) : 0) | ((pawn & 7) < 7 ? bit(pawn - 7) : 0);
+            bool anyWin = false, anyDraw = false, anyUnknown = false;
+            auto visit = [&](int successor) {
+                if (result[successor] == KPK_WIN) anyWin = true;
+                else if (result[successor] == KPK_DRAW) anyDraw = true;
+                else anyUnknown = true;
+            };
+
+            if (stm == 0) {
+                uint64_t targets = kingAttacksBB[strongKing] & ~kingAttacksBB[weakKing] & ~bit(pawn);
+                for (int to = 0; to < 64; ++to) if (targets & bit(to)) visit(kpkIndex(1, to, weakKing, pawn));
+                if (row > 1 && pawn - 8 != strongKing && pawn - 8 != weakKing) {
+                    visit(kpkIndex(1, strongKing, weakKing, pawn - 8));
+                    if (row == 6 && pawn - 16 != strongKing && pawn - 16 != weakKing) visit(kpkIndex(1, strongKing, weakKing, pawn - 16));
+                }
+                if (anyWin) result[idx] = KPK_WIN;
+                else if (!anyUnknown) result[idx] = KPK_DRAW;
+            } else {
+                uint64_t targets = kingAttacksBB[weakKing] & ~kingAttacksBB[strongKing] & ~pawnAttacks & ~bit(pawn);
+                for (int to = 0; to < 64; ++to) if (targets & bit(to)) visit(kpkIndex(0, strongKing, to, pawn));
+                if (anyDraw) result[idx] = KPK_DRAW;
+                else if (!anyUnknown) result[idx] = KPK_WIN;
+            }
+            if (result[idx] != KPK_UNKNOWN) changed = true;
+        }
+    }
+
+    std::memset(kpkWins, 0, sizeof(kpkWins));
+    for (int idx = 0; idx < size; ++idx) {
+        if (result[idx] == KPK_WIN) kpkWins[idx >> 3] |= (uint8_t)(1 << (idx & 7));
+    }
+    kpkReady = true;
+}
+
+// Pawnless tables
+
+struct PawnlessTable {
+    char name[8];
+    int count;    // Pieces, kings included
+    int types[4]; // Slot 0 strong king, slot 1 weak king, then the other pieces
+    int sides[4]; // 0 strong side, 1 weak side
+};
+
+// Three-piece tables first: captures in the four-piece tables lead into them
+static const PawnlessTable pawnlessTables[] = {
+    {"KQK",  3, {5, 5, 4, 0}, {0, 1, 0, 0}},
+    {"KRK",  3, {5, 5, 3, 0}, {0, 1, 0, 0}},
+    {"KQKR", 4, {5, 5, 4, 3}, {0, 1, 0, 1}},
+    {"KRKB", 4, {5, 5, 3, 2}, {0, 1, 0, 1}},
+    {"KRKN", 4, {5, 5, 3, 1}, {0, 1, 0, 1}},
+};
+static const int PAWNLESS_TABLE_COUNT = sizeof(pawnlessTables) / sizeof(pawnlessTables[0]);
+
+enum { GEN_UNKNOWN, GEN_WIN, GEN_LOSS, GEN_DRAW, GEN_INVALID };
+
+static uint64_t tableSize(const PawnlessTable& table) {
+    uint64_t size = 2 * 10;
+    for (int i = 1; i < table.count; ++i) size *= 64;
+    return size;
+}
+
+// Index of a position (stm 0 = strong side to move). Of the symmetries taking the strong
+// king into the triangle, the one giving the smallest remaining squares is used, so
+// symmetric positions always share an index.
+static uint64_t tableIndex(const PawnlessTable& table, int stm, const int* sq) {
+    int best[4] = {0, 0, 0, 0};
+    for (int k = 0; k < kingTransformCount[sq[0]]; ++k) {
+        int t = kingTransforms[sq[0]][k], candidate[4] = {0, 0, 0, 0};
+        for (int i = 0; i < table.count; ++i) candidate[i] = transformTable[t][sq[i]];
+        if (k == 0 || std::lexicographical_compare(candidate + 1, candidate + table.count, best + 1, best + table.count)) {
+            std::copy(candidate, candidate + 4, best);
+        }
+    }
+    uint64_t idx = (uint64_t)(stm * 10 + triangleIndex[best[0]]);
+    for (int i = 1; i < table.count; ++i) idx = idx * 64 + best[i];
+    return idx;
+}
+
+static void decodeIndex(const PawnlessTable& table, uint64_t idx, int& stm, int* sq) {
+    for (int i = table.count - 1; i >= 1; --i) { sq[i] = (int)(idx % 64); idx /= 64; }
+    sq[0] = triangleSquare[idx % 10];
+    stm = (int)(idx / 10);
+}
+
+// Is the king of 'side' attacked by the other side's pieces ('skip' = captured slot or -1)?
+static bool kingAttacked(const PawnlessTable& table, const int* sq, int side, int skip) {
+    uint64_t occupied = 0;
+    for (int i = 0; i < table.count; ++i) if (i != skip) occupied |= bit(sq[i]);
+    for (int i = 0; i < table.count; ++i) {
+        if (i == skip || table.sides[i] == side) continue;
+        if (pieceAttacks(table.types[i], sq[i], occupied) & bit(sq[side])) return true;
+    }
+    return false;
+}
+
+// Result (GEN_*) for 'stm' after the piece in slot 'captured' was taken: a queen or rook
+// left alone with the kings is looked up in KQK / KRK, anything else is a draw
+template <typename Lookup>
+static int capturedResult(const PawnlessTable& table, const int* sq, int captured, int stm, Lookup lookup) {
+    for (int i = 2; i < table.count; ++i) {
+        if (i == captured) continue;
+        int type = table.types[i], owner = table.sides[i];
+        if (type != 4 && type != 3) return GEN_DRAW;
+        int subTable = (type == 4) ? 0 : 1;
+        int subSq[3] = {sq[owner], sq[owner ^ 1], sq[i]};
+        return lookup(subTable, tableIndex(pawnlessTables[subTable], stm == owner ? 0 : 1, subSq));
+    }
+    return GEN_DRAW;
+}
+
+// Retrograde analysis of one table. Positions are resolved from mates and captures backwards:
+// a predecessor of a loss is a win, and a position whose distinct successors are all wins
+// (with no drawing capture) is a loss. Whatever is left unresolved is a draw.
+static std::vector<uint8_t> solveTable(const PawnlessTable& table, const std::vector<uint8_t>* solved) {
+    uint64_t size = tableSize(table);
+    std::vector<uint8_t> value(size, GEN_UNKNOWN);
+    std::vector<uint8_t> counter(size, 0); // Unresolved distinct successors; bit 7: a capture draws
+    const uint8_t DRAWING_CAPTURE = 0x80;
+    auto lookup = [&](int subTable, uint64_t idx) { return (int)solved[subTable][idx]; };
+
+    for (uint64_t idx = 0; idx < size; ++idx) {
+        int stm, sq[4];
+        decodeIndex(table, idx, stm, sq);
+        bool valid = tableIndex(table, stm, sq) == idx && !(kingAttacksBB[sq[0]] & bit(sq[1]));
+        for (int i = 0; i < table.count && valid; ++i) {
+            for (int j = i + 1; j < table.count; ++j) if (sq[i] == sq[j]) valid = false;
+        }
+        if (valid && kingAttacked(table, sq, stm ^ 1, -1)) valid = false;
+        if (!valid) value[idx] = GEN_INVALID;
+    }
+
+    std::vector<uint64_t> queue;
+    for (uint64_t idx = 0; idx < size; ++idx) {
+        if (value[idx] == GEN_INVALID) continue;
+        int stm, sq[4];
+        decodeIndex(table, idx, stm, sq);
+        uint64_t occupied = 0, own = 0;
+        for (int i = 0; i < table.count; ++i) {
+            occupied |= bit(sq[i]);
+            if (table.sides[i] == stm) own |= bit(sq[i]);
+        }
+        int legalMoves = 0, successorCount = 0;
+        uint64_t successors[64];
+        bool win = false, drawingCapture = false;
+        for (int i = 0; i < table.count; ++i) {
+            if (table.sides[i] != stm) continue;
+            uint64_t targets = pieceAttacks(table.types[i], sq[i], occupied) & ~own;
+            for (int to = 0; to < 64; ++to) {
+                if (!(targets & bit(to))) continue;
+                int next[4], captured = -1;
+                std::copy(sq, sq + 4, next);
+                next[i] = to;
+                for (int j = 0; j < table.count; ++j) if (j != i && sq[j] == to) captured = j;
+                if (kingAttacked(table, next, stm, captured)) continue;
+                legalMoves++;
+                if (captured >= 0) {
+                    int after = capturedResult(table, next, captured, stm ^ 1, lookup);
+                    if (after == GEN_LOSS) win = true;
+                    else if (after != GEN_WIN) drawingCapture = true;
+                } else {
+                    uint64_t successor = tableIndex(table, stm ^ 1, next);
+                    if (std::find(successors, successors + successorCount, successor) == successors + successorCount) {
+                        successors[successorCount++] = successor;
+                    }
+                }
+            }
+        }
+        if (legalMoves == 0) {
+            value[idx] = kingAttacked(table, sq, stm, -1) ? GEN_LOSS : GEN_DRAW;
+        } else if (win) {
+            value[idx] = GEN_WIN;
+        } else if (successorCount == 0 && !drawingCapture) {
+            value[idx] = GEN_LOSS;
+        } else {
+            counter[idx] = (uint8_t)(successorCount | (drawingCapture ? DRAWING_CAPTURE : 0));
+        }
+        if (value[idx] == GEN_WIN || value[idx] == GEN_LOSS) queue.push_back(idx);
+    }
+
+    for (size_t q = 0; q < queue.size(); ++q) {
+        uint64_t idx = queue[q];
+        int stm, sq[4];
+        decodeIndex(table, idx, stm, sq);
+        int mover = stm ^ 1;
+        uint64_t occupied = 0;
+        for (int i = 0; i < table.count; ++i) occupied |= bit(sq[i]);
+        int predecessorCount = 0;
+        uint64_t predecessors[64];
+        for (int i = 0; i < table.count; ++i) {
+            if (table.sides[i] != mover) continue;
+            uint64_t targets = pieceAttacks(table.types[i], sq[i], occupied) & ~occupied;
+            for (int from = 0; from < 64; ++from) {
+                if (!(targets & bit(from))) continue;
+                int previous[4];
+                std::copy(sq, sq + 4, previous);
+                previous[i] = from;
+                uint64_t predecessor = tableIndex(table, mover, previous);
+                if (value[predecessor] == GEN_INVALID) continue;
+                if (std::find(predecessors, predecessors + predecessorCount, predecessor) == predecessors + predecessorCount) {
+                    predecessors[predecessorCount++] = predecessor;
+                }
+            }
+        }
+        for (int p = 0; p < predecessorCount; ++p) {
+            uint64_t predecessor = predecessors[p];
+            if (value[predecessor] != GEN_UNKNOWN) continue;
+            if (value[idx] == GEN_LOSS) {
+                value[predecessor] = GEN_WIN;
+                queue.push_back(predecessor);
+            } else if (--counter[predecessor] == 0) {
+                value[predecessor] = GEN_LOSS;
+                queue.push_back(predecessor);
+            }
+        }
+    }
+
+    for (uint64_t idx = 0; idx < size; ++idx) {
+        if (value[idx] == GEN_UNKNOWN || value[idx] == GEN_INVALID) value[idx] = GEN_DRAW;
+    }
+    return value;
+}
+
+// Loaded file tables (2 bits per position), nullptr if not available
+static const uint8_t* fileTables[PAWNLESS_TABLE_COUNT];
+static uint64_t fileTableKeys[PAWNLESS_TABLE_COUNT][2]; // Material keys with the strong side white / black
+static void* fileMapping = nullptr;
+static size_t fileMappingBytes = 0;
+
+// Material key of a table with the strong side playing 'colour' (0 white, 1 black)
+static uint64_t tableMaterialKey(const PawnlessTable& table, int colour) {
+    uint64_t key = 0;
+    for (int i = 0; i < table.count; ++i) key += materialKeyUnit((table.sides[i] ^ colour) * 6 + table.types[i]);
+    return key;
+}
+
+static int readPacked(const uint8_t* data, uint64_t idx) { return (data[idx >> 2] >> ((idx & 3) * 2)) & 3; }
+
+bool bitbaseFileLoaded() { return fileMapping != nullptr; }
+
+bool loadBitbaseFile(const std::string& path) {
+    initGeometry();
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Warning: Could not open bitbase file: " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(BitbaseFileHeader)) {
+        std::cerr << "Warning: Bitbase file too small: " << path << std::endl;
+        close(fd);
+        return false;
+    }
+    size_t fileBytes = (size_t)st.st_size;
+    void* map = mmap(nullptr, fileBytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << "Warning: Could not map bitbase file: " << path << std::endl;
+        return false;
+    }
+
+    const uint8_t* base = static_cast<const uint8_t*>(map);
+    BitbaseFileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    const char* problem = nullptr;
+    if (std::memcmp(header.magic, BITBASE_FILE_MAGIC, sizeof(header.magic)) != 0) problem = "not a bitbase file";
+    else if (header.version != BITBASE_FILE_VERSION) problem = "unsupported version";
+    else if (header.byteOrder != TT_FILE_BYTE_ORDER) problem = "different byte order";
+    else if (sizeof(header) + (uint64_t)header.tableCount * sizeof(BitbaseFileTable) > fileBytes) problem = "truncated table list";
+
+    const uint8_t* tables[PAWNLESS_TABLE_COUNT] = {};
+    for (uint32_t n = 0; !problem && n < header.tableCount; ++n) {
+        BitbaseFileTable entry;
+        std::memcpy(&entry, base + sizeof(header) + n * sizeof(entry), sizeof(entry));
+        for (int t = 0; t < PAWNLESS_TABLE_COUNT; ++t) {
+            if (std::strncmp(entry.name, pawnlessTables[t].name, sizeof(entry.name)) != 0) continue;
+            if (entry.bytes != (tableSize(pawnlessTables[t]) + 3) / 4 || entry.offset + entry.bytes > fileBytes) problem = "bad table size";
+            else tables[t] = base + entry.offset;
+        }
+    }
+    if (problem) {
+        std::cerr << "Warning: Incompatible bitbase file (" << problem << "): " << path << std::endl;
+        munmap(map, fileBytes);
+        return false;
+    }
+
+    if (fileMapping) munmap(fileMapping, fileMappingBytes);
+    fileMapping = map;
+    fileMappingBytes = fileBytes;
+    std::copy(tables, tables + PAWNLESS_TABLE_COUNT, fileTables);
+    for (int t = 0; t < PAWNLESS_TABLE_COUNT; ++t) {
+        for (int colour = 0; colour < 2; ++colour) fileTableKeys[t][colour] = tableMaterialKey(pawnlessTables[t], colour);
+    }
+    return true;
+}
+
+bool generateBitbaseFile(const std::string& path) {
+    initGeometry();
+    std::vector<uint8_t> solved[PAWNLESS_TABLE_COUNT];
+    std::vector<uint8_t> packed[PAWNLESS_TABLE_COUNT];
+    for (int t = 0; t < PAWNLESS_TABLE_COUNT; ++t) {
+        auto start = std::chrono::steady_clock::now();
+        solved[t] = solveTable(pawnlessTables[t], solved);
+        uint64_t wins = 0, losses = 0;
+        packed[t].assign((solved[t].size() + 3) / 4, 0);
+        for (uint64_t idx = 0; idx < solved[t].size(); ++idx) {
+            int v = (solved[t][idx] == GEN_WIN) ? 1 : (solved[t][idx] == GEN_LOSS) ? 2 : 0;
+            if (v == 1) wins++;
+            if (v == 2) losses++;
+            packed[t][idx >> 2] |= (uint8_t)(v << ((idx & 3) * 2));
+        }
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        std::cout << pawnlessTables[t].name << ": " << solved[t].size() << " positions, " << wins << " wins, "
+                  << losses << " losses (" << ms << " ms)" << std::endl;
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not write bitbase file: " << path << std::endl;
+        return false;
+    }
+    BitbaseFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, BITBASE_FILE_MAGIC, sizeof(header.magic));
+    header.version = BITBASE_FILE_VERSION;
+    header.byteOrder = TT_FILE_BYTE_ORDER;
+    header.tableCount = PAWNLESS_TABLE_COUNT;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    uint64_t offset = sizeof(header) + PAWNLESS_TABLE_COUNT * sizeof(BitbaseFileTable);
+    for (int t = 0; t < PAWNLESS_TABLE_COUNT; ++t) {
+        BitbaseFileTable entry;
+        std::memset(&entry, 0, sizeof(entry));
+        std::memcpy(entry.name, pawnlessTables[t].name, sizeof(entry.name));
+        entry.offset = offset;
+        entry.bytes = packed[t].size();
+        file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        offset += entry.bytes;
+    }
+    for (int t = 0; t < PAWNLESS_TABLE_COUNT; ++t) file.write(reinterpret_cast<const char*>(packed[t].data()), packed[t].size());
+    if (!file) {
+        std::cerr << "Error: Could not write bitbase file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Probing
+
+static BitbaseResult probeKPK(const BoardState& state, int strongColour) {
+    int strongKing = -1, weakKing = -1, pawn = -1;
+    for (int r = 0; r < 8; ++r) {
+        for (int c = 0; c < 8; ++c) {
+            int p = pieceIndex(state.board[r][c]);
+            if (p < 0) continue;
+            // Flip rows for black so the pawn moves towards row 0
+            int sq = (strongColour == 0) ? r * 8 + c : (7 - r) * 8 + c;
+            if (p == strongColour * 6 + 5) strongKing = sq;
+            else if (p == strongColour * 6) pawn = sq;
+            else weakKing = sq;
+        }
+    }
+    if ((pawn >> 3) == 0 || (pawn >> 3) == 7) return BITBASE_UNKNOWN;
+    if ((pawn & 7) > 3) { strongKing ^= 7; weakKing ^= 7; pawn ^= 7; }
+    int stm = (state.whiteToMove == (strongColour == 0)) ? 0 : 1;
+    int idx = kpkIndex(stm, strongKing, weakKing, pawn);
+    if (!(kpkWins[idx >> 3] & (1 << (idx & 7)))) return BITBASE_DRAW;
+    return stm == 0 ? BITBASE_WIN : BITBASE_LOSS;
+}
+
+static BitbaseResult probePawnless(const BoardState& state, int table, int strongColour) {
+    const PawnlessTable& t = pawnlessTables[table];
+    int sq[4] = {0, 0, 0, 0};
+    for (int r = 0; r < 8; ++r) {
+        for (int c = 0; c < 8; ++c) {
+            int p = pieceIndex(state.board[r][c]);
+            if (p < 0) continue;
+            for (int i = 0; i < t.count; ++i) {
+                if (p == (t.sides[i] ^ strongColour) * 6 + t.types[i]) sq[i] = r * 8 + c;
+            }
+        }
+    }
+    int stm = (state.whiteToMove == (strongColour == 0)) ? 0 : 1;
+    int v = readPacked(fileTables[table], tableIndex(t, stm, sq));
+    return v == 1 ? BITBASE_WIN : v == 2 ? BITBASE_LOSS : BITBASE_DRAW;
+}
+
+BitbaseResult probeBitbase(const BoardState& state) {
+    static const uint64_t kpkKeys[2] = {
+        materialKeyUnit(0) + materialKeyUnit(5) + materialKeyUnit(11),
+        materialKeyUnit(6) + materialKeyUnit(5) + materialKeyUnit(11)
+    };
+    for (int colour = 0; colour < 2; ++colour) {
+        if (state.materialKey == kpkKeys[colour]) return kpkReady ? probeKPK(state, colour) : BITBASE_UNKNOWN;
+    }
+    if (!fileMapping) return BITBASE_UNKNOWN;
+    for (int t = 0; t < PAWNLESS_TABLE_COUNT; ++t) {
+        if (!fileTables[t]) continue;
+        for (int colour = 0; colour < 2; ++colour) {
+            if (state.materialKey == fileTableKeys[t][colour]) return probePawnless(state, t, colour);
+        }
+    }
+    return BITBASE_UNKNOWN;
+}
@@ -0,0 +1,49 @@
+#ifndef BITBASE_H
+#define BITBASE_H
+
+#include "types.h"
+#include <cstdint>
+#include <string>
+
+// Endgame Bitbases
+// Win/draw/loss tables built by retrograde analysis. KPK is generated in memory at
+// startup. The pawnless endings (KQK, KRK, KQKR, KRKB, KRKN) take a few seconds to
+// build, so they are generated offline with `chess_engine makebitbase <file>` and
+// memory-mapped from the file named by the "BitbaseFile" option.
+//
+// Pawnless tables store 2 bits per position (0 draw, 1 win, 2 loss for the side to
+// move). Positions are indexed with the strong king mapped into the a1-d1-d4 triangle
+// and the remaining squares in their smallest symmetric form.
+
+// Result for the side to move
+enum BitbaseResult { BITBASE_UNKNOWN = -2, BITBASE_LOSS = -1, BITBASE_DRAW = 0, BITBASE_WIN = 1 };
+
+// Header of a bitbase file; BitbaseFileTable entries and the packed tables follow it
+struct BitbaseFileHeader {
+    char magic[8];        // BITBASE_FILE_MAGIC
+    uint32_t version;     // BITBASE_FILE_VERSION
+    uint32_t byteOrder;   // TT_FILE_BYTE_ORDER as written by the generating machine
+    uint32_t tableCount;
+    uint32_t padding;
+};
+
+struct BitbaseFileTable {
+    char name[8];         // "KQKR": strong side pieces, then weak side pieces
+    uint64_t offset;      // From the start of the file
+    uint64_t bytes;
+};
+
+// Build the KPK bitbase (idempotent)
+void initKPKBitbase();
+
+// Probe every available bitbase; BITBASE_UNKNOWN if the material is not covered
+BitbaseResult probeBitbase(const BoardState& state);
+
+// Memory-map a bitbase file written by generateBitbaseFile. Errors are reported on stderr and return false.
+bool loadBitbaseFile(const std::string& path);
+bool bitbaseFileLoaded();
+
+// Generate the pawnless tables and write them to 'path' (progress on stdout)
+bool generateBitbaseFile(const std::string& path);
+
+#endif // BITBASE_H
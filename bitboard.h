@@ -0,0 +1,39 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+
+// Bitboards use the board array's square numbering: square = row * 8 + col, with
+// row 0 being the 8th rank. White pawns therefore move towards lower square numbers.
+typedef uint64_t Bitboard;
+
+constexpr Bitboard FILE_A_BB = 0x0101010101010101ULL;
+constexpr Bitboard FILE_H_BB = FILE_A_BB << 7;
+constexpr Bitboard ROW_0_BB = 0xFFULL;
+constexpr Bitboard LIGHT_SQUARES_BB = 0xAA55AA55AA55AA55ULL; // a8 (square 0) is light
+
+constexpr Bitboard squareBB(int sq) { return 1ULL << sq; }
+inline int popCount(Bitboard b) { return __builtin_popcountll(b); }
+inline int lsbIndex(Bitboard b) { return __builtin_ctzll(b); }
+inline int msbIndex(Bitboard b) { return 63 - __builtin_clzll(b); }
+inline int popLsb(Bitboard& b) { int sq = lsbIndex(b); b &= b - 1; return sq; }
+
+// One-step shifts. "North" is towards the 8th rank (white's forward direction).
+constexpr Bitboard shiftNorth(Bitboard b) { return b >> 8; }
+constexpr Bitboard shiftSouth(Bitboard b) { return b << 8; }
+constexpr Bitboard shiftEast(Bitboard b) { return (b & ~FILE_H_BB) << 1; }
+constexpr Bitboard shiftWest(Bitboard b) { return (b & ~FILE_A_BB) >> 1; }
+
+// Squares strictly north / south of any set square on the same file
+inline Bitboard northSpan(Bitboard b) {
+    b = shiftNorth(b);
+    b |= b >> 8; b |= b >> 16; b |= b >> 32;
+    return b;
+}
+inline Bitboard southSpan(Bitboard b) {
+    b = shiftSouth(b);
+    b |= b << 8; b |= b << 16; b |= b << 32;
+    return b;
+}
+
+#endif // BITBOARD_H
@@ -1,12 +1,131 @@
 #include "board.h"
 #include "constants.h"
+#include "attacks.h"
 #include <sstream>
 #include <algorithm>
 #include <cctype>
 #include <vector>
 
+// Zobrist keys, filled once by initZobrist() with a fixed seed so keys are stable across runs
+uint64_t zobristPieces[12][64];
+uint64_t zobristSide;
+uint64_t zobristCastling[16];
+uint64_t zobristEnPassant[8];
+
+// SplitMix64 step for Zobrist key generation
+static uint64_t nextZobristRandom(uint64_t& seed) {
+    uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Initialize Zobrist keys (idempotent; called before the first BoardState is set up)
+void initZobrist() {
+    static bool initialized = false;
+    if (initialized) return;
+    uint64_t seed = 0x476F7468616D2121ULL;
+    for (int p = 0; p < 12; ++p) for (int sq = 0; sq < 64; ++sq) zobristPieces[p][sq] = nextZobristRandom(seed);
+    zobristSide = nextZobristRandom(seed);
+    for (int i = 0; i < 16; ++i) zobristCastling[i] = nextZobristRandom(seed);
+    for (int f = 0; f < 8; ++f) zobristEnPassant[f] = nextZobristRandom(seed);
+    initialized = true;
+}
+
+// Zobrist key of the side to move, castling rights and en passant file
+static uint64_t stateKey(const BoardState& state) {
+    uint64_t key = state.whiteToMove ? 0 : zobristSide;
+    int castling = (state.whiteKingSideCastle ? 1 : 0) | (state.whiteQueenSideCastle ? 2 : 0) |
+                   (state.blackKingSideCastle ? 4 : 0) | (state.blackQueenSideCastle ? 8 : 0);
+    key ^= zobristCastling[castling];
+    if (state.enPassantTarget.first != -1) key ^= zobristEnPassant[state.enPassantTarget.second];
+    return key;
+}
+
+// Compute the Zobrist key of a position from scratch
+uint64_t computeHashKey(const BoardState& state) {
+    uint64_t key = 0;
+    for (int r = 0; r < 8; ++r) {
+        for (int c = 0; c < 8; ++c) {
+            int p = pieceIndex(state.board[r][c]);
+            if (p >= 0) key ^= zobristPieces[p][r * 8 + c];
+        }
+    }
+    return key ^ stateKey(state);
+}
+
+// Compute the Zobrist key of the pawns only
+uint64_t computePawnKey(const BoardState& state) {
+    uint64_t key = 0;
+    for (int r = 0; r < 8; ++r) {
+        for (int c = 0; c < 8; ++c) {
+            if (state.board[r][c] == W_PAWN) key ^= zobristPieces[pieceIndex(W_PAWN)][r * 8 + c];
+            else if (state.board[r][c] == B_PAWN) key ^= zobristPieces[pieceIndex(B_PAWN)][r * 8 + c];
+        }
+    }
+    return key;
+}
+
+// Rebuild every incrementally updated field (keys, piece bitboards, material/PST scores
+// and game phase) from the board array
+void computeIncrementalState(BoardState& state) {
+    state.hashKey = computeHashKey(state);
+    state.pawnKey = computePawnKey(state);
+    state.materialKey = 0;
+    std::fill(state.pieceBB, state.pieceBB + 12, 0);
+    state.occupancy[0] = state.occupancy[1] = 0;
+    state.psqMg = state.psqEg = 0;
+    state.phase = 0;
+    state.parentKey = 0;
+    state.dirtyCount = 0;
+    for (int r = 0; r < 8; ++r) {
+        for (int c = 0; c < 8; ++c) {
+            int p = pieceIndex(state.board[r][c]);
+            if (p < 0) continue;
+            int sq = r * 8 + c;
+            state.materialKey += materialKeyUnit(p);
+            state.pieceBB[p] |= 1ULL << sq;
+            state.occupancy[p / 6] |= 1ULL << sq;
+            state.psqMg += pieceSquareMg(p, sq);
+            state.psqEg += pieceSquareEg(p, sq);
+            state.phase += phase_weights[p % 6];
+        }
+    }
+}
+
+// Place a piece on an empty square, keeping the incremental fields in step
+static void putPiece(BoardState& state, char piece, int r, int c) {
+    int p = pieceIndex(piece), sq = r * 8 + c;
+    state.board[r][c] = piece;
+    state.hashKey ^= zobristPieces[p][sq];
+    state.materialKey += materialKeyUnit(p);
+    state.pieceBB[p] |= 1ULL << sq;
+    state.occupancy[p / 6] |= 1ULL << sq;
+    if (p % 6 == 0) state.pawnKey ^= zobristPieces[p][sq];
+    state.psqMg += pieceSquareMg(p, sq);
+    state.psqEg += pieceSquareEg(p, sq);
+    state.phase += phase_weights[p % 6];
+    if (state.dirtyCount < 4) state.dirtyPieces[state.dirtyCount++] = {(int8_t)p, (int8_t)sq, true};
+}
+
+// Remove the piece on a square (no-op if it is empty)
+static void removePiece(BoardState& state, int r, int c) {
+    int p = pieceIndex(state.board[r][c]), sq = r * 8 + c;
+    if (p < 0) return;
+    state.board[r][c] = EMPTY;
+    state.hashKey ^= zobristPieces[p][sq];
+    state.materialKey -= materialKeyUnit(p);
+    state.pieceBB[p] &= ~(1ULL << sq);
+    state.occupancy[p / 6] &= ~(1ULL << sq);
+    if (p % 6 == 0) state.pawnKey ^= zobristPieces[p][sq];
+    state.psqMg -= pieceSquareMg(p, sq);
+    state.psqEg -= pieceSquareEg(p, sq);
+    state.phase -= phase_weights[p % 6];
+    if (state.dirtyCount < 4) state.dirtyPieces[state.dirtyCount++] = {(int8_t)p, (int8_t)sq, false};
+}
+
 // BoardState constructor
-BoardState::BoardState() { reset(); }
+BoardState::BoardState() { initZobrist(); reset(); }
 
 // BoardState reset method
 void BoardState::reset() {
@@ -22,30 +141,19 @@ void BoardState::reset() {
     blackKingSideCastle = blackQueenSideCastle = true;
     enPassantTarget = {-1,-1};
     halfmoveClock = 0; fullmoveNumber = 1;
-    positionCounts.clear();
-    currentFenKey = getPositionKey();
-    addCurrentPositionToHistory();
+    computeIncrementalState(*this);
 }
 
-// Get position key for repetition detection
-std::string BoardState::getPositionKey() const {
-    std::stringstream ss;
-    for(int r=0; r<8; ++r) for(int c=0; c<8; ++c) ss << board[r][c];
-    ss << (whiteToMove ? 'w' : 'b');
-    ss << (whiteKingSideCastle ? 'K' : '-'); ss << (whiteQueenSideCastle ? 'Q' : '-');
-    ss << (blackKingSideCastle ? 'k' : '-'); ss << (blackQueenSideCastle ? 'q' : '-');
-    if (enPassantTarget.first != -1) ss << (char)('a'+enPassantTarget.second) << (char)('8'-enPassantTarget.first);
-    else ss << '-';
-    return ss.str();
-}
+// Game history (see board.h)
+std::vector<uint64_t> gameHistory;
 
-// Add current position to history
-void BoardState::addCurrentPositionToHistory() { positionCounts[currentFenKey]++; }
+int repetitionCount(uint64_t hashKey) {
+    return (int)std::count(gameHistory.begin(), gameHistory.end(), hashKey);
+}
 
 // Parse FEN string
 void BoardState::parseFen(const std::string& fenStr) {
     std::fill(&board[0][0], &board[0][0]+sizeof(board), EMPTY);
-    positionCounts.clear();
     std::istringstream fenStream(fenStr); std::string part;
     fenStream >> part; int r=0, c=0;
     for(char sym : part) {
@@ -60,13 +168,40 @@ void BoardState::parseFen(const std::string& fenStr) {
     if(part=="-") enPassantTarget={-1,-1}; else { enPassantTarget = {'8'-part[1], part[0]-'a'}; }
     if(fenStream >> part) halfmoveClock=std::stoi(part); else halfmoveClock=0;
     if(fenStream >> part) fullmoveNumber=std::stoi(part); else fullmoveNumber=1;
-    currentFenKey = getPositionKey();
-    addCurrentPositionToHistory();
+    computeIncrementalState(*this);
 }
 
-// Update FEN key
-void BoardState::updateFenKey() {
-    currentFenKey = getPositionKey();
+bool isValidFen(const std::string& fen) {
+    std::istringstream fenStream(fen);
+    std::string placement, side, castling, enPassant, clock;
+    if (!(fenStream >> placement >> side >> castling >> enPassant)) return false;
+    int r = 0, c = 0, pieces[2] = {0, 0}, kings[2] = {0, 0};
+    for (char sym : placement) {
+        if (sym == '/') {
+            if (c != 8) return false;
+            r++; c = 0;
+        } else if (sym >= '1' && sym <= '8') {
+            c += sym - '0';
+        } else {
+            int p = pieceIndex(sym);
+            if (p < 0 || r > 7 || c > 7) return false;
+            if (p % 6 == 0 && (r == 0 || r == 7)) return false;
+            pieces[p / 6]++;
+            if (p % 6 == 5) kings[p / 6]++;
+            c++;
+        }
+        if (c > 8) return false;
+    }
+    if (r != 7 || c != 8 || kings[0] != 1 || kings[1] != 1 || pieces[0] > 16 || pieces[1] > 16) return false;
+    if (side != "w" && side != "b") return false;
+    if (castling != "-" && castling.find_first_not_of("KQkq") != std::string::npos) return false;
+    if (enPassant != "-" && (enPassant.size() != 2 || enPassant[0] < 'a' || enPassant[0] > 'h' ||
+                             (enPassant[1] != '3' && enPassant[1] != '6'))) return false;
+    // Clocks are optional, but parseFen needs them numeric
+    for (int i = 0; i < 2 && fenStream >> clock; ++i) {
+        if (clock.size() > 4 || clock.find_first_not_of("0123456789") != std::string::npos) return false;
+    }
+    return true;
 }
 
 // Helper functions
@@ -77,7 +212,7 @@ bool isBlackPiece(char piece) { return piece >= 'a' && piece <= 'z'; }
 
 // Move::isCapture implementation
 bool Move::isCapture(const BoardState& state) const {
-    return isEnPassantCapture || (getPieceAt(state, toRow, toCol) != EMPTY);
+    return isEnPassantCapture || state.board[toRow][toCol] != EMPTY;
 }
 
 // Apply move to board state
@@ -85,12 +220,15 @@ void apply_raw_move_to_board(BoardState& state, const Move& move) {
     char piece = state.board[move.fromRow][move.fromCol];
     char captured = state.board[move.toRow][move.toCol];
     int ep_cap_row = state.whiteToMove ? move.toRow + 1 : move.toRow - 1;
-    state.board[move.toRow][move.toCol] = piece;
-    state.board[move.fromRow][move.fromCol] = EMPTY;
-    if (move.promotionPiece != EMPTY) { state.board[move.toRow][move.toCol] = move.promotionPiece; }
-    else if (move.isKingSideCastle) { state.board[move.fromRow][5] = state.board[move.fromRow][7]; state.board[move.fromRow][7] = EMPTY; }
-    else if (move.isQueenSideCastle) { state.board[move.fromRow][3] = state.board[move.fromRow][0]; state.board[move.fromRow][0] = EMPTY; }
-    else if (move.isEnPassantCapture) { state.board[ep_cap_row][move.toCol] = EMPTY; }
+    state.parentKey = state.hashKey;
+    state.dirtyCount = 0;
+    state.hashKey ^= stateKey(state);
+    removePiece(state, move.toRow, move.toCol);
+    removePiece(state, move.fromRow, move.fromCol);
+    putPiece(state, move.promotionPiece != EMPTY ? move.promotionPiece : piece, move.toRow, move.toCol);
+    if (move.isKingSideCastle) { char rook = state.board[move.fromRow][7]; removePiece(state, move.fromRow, 7); putPiece(state, rook, move.fromRow, 5); }
+    else if (move.isQueenSideCastle) { char rook = state.board[move.fromRow][0]; removePiece(state, move.fromRow, 0); putPiece(state, rook, move.fromRow, 3); }
+    else if (move.isEnPassantCapture) { removePiece(state, ep_cap_row, move.toCol); }
     state.enPassantTarget = {-1, -1};
     if (toupper(piece) == W_PAWN && abs(move.toRow - move.fromRow) == 2) { state.enPassantTarget = {(move.fromRow + move.toRow) / 2, move.fromCol}; }
     if (piece == W_KING) state.whiteKingSideCastle = state.whiteQueenSideCastle = false;
@@ -100,44 +238,19 @@ void apply_raw_move_to_board(BoardState& state, const Move& move) {
     if (captured == W_ROOK) { if (move.toRow == 7 && move.toCol == 0) state.whiteQueenSideCastle = false; else if (move.toRow == 7 && move.toCol == 7) state.whiteKingSideCastle = false; }
     else if (captured == B_ROOK) { if (move.toRow == 0 && move.toCol == 0) state.blackQueenSideCastle = false; else if (move.toRow == 0 && move.toCol == 7) state.blackKingSideCastle = false; }
     state.whiteToMove = !state.whiteToMove;
-    state.updateFenKey();
+    state.hashKey ^= stateKey(state);
 }
 
 // Check if square is attacked
 bool isSquareAttacked(const BoardState& state, int r, int c, bool byWhiteAttacker) {
-    int pawn_dir = byWhiteAttacker ? 1 : -1;
-    char attacking_pawn = byWhiteAttacker ? W_PAWN : B_PAWN;
-    if (getPieceAt(state, r + pawn_dir, c - 1) == attacking_pawn) return true;
-    if (getPieceAt(state, r + pawn_dir, c + 1) == attacking_pawn) return true;
-    char attacking_knight = byWhiteAttacker ? W_KNIGHT : B_KNIGHT;
-    const std::vector<std::pair<int, int>> knight_deltas = {{-2,-1},{-2,1},{-1,-2},{-1,2},{1,-2},{1,2},{2,-1},{2,1}};
-    for (auto d : knight_deltas) { if (getPieceAt(state, r + d.first, c + d.second) == attacking_knight) return true; }
-    char attacking_rook = byWhiteAttacker ? W_ROOK : B_ROOK;
-    char attacking_bishop = byWhiteAttacker ? W_BISHOP : B_BISHOP;
-    char attacking_queen = byWhiteAttacker ? W_QUEEN : B_QUEEN;
-    const std::vector<std::pair<int, int>> rook_dirs = {{0,1},{0,-1},{1,0},{-1,0}};
-    const std::vector<std::pair<int, int>> bishop_dirs = {{1,1},{1,-1},{-1,1},{-1,-1}};
-    for (auto dir : rook_dirs) {
-        for (int i = 1; i < 8; ++i) {
-            int nr=r+dir.first*i, nc=c+dir.second*i; if (!isSquareOnBoard(nr, nc)) break;
-            char p=state.board[nr][nc]; if (p==attacking_rook || p==attacking_queen) return true; if (p!=EMPTY) break;
-        }
-    }
-    for (auto dir : bishop_dirs) {
-        for (int i = 1; i < 8; ++i) {
-            int nr=r+dir.first*i, nc=c+dir.second*i; if (!isSquareOnBoard(nr, nc)) break;
-            char p=state.board[nr][nc]; if (p==attacking_bishop || p==attacking_queen) return true; if (p!=EMPTY) break;
-        }
-    }
-    char attacking_king = byWhiteAttacker ? W_KING : B_KING;
-    const std::vector<std::pair<int, int>> king_deltas = {{-1,-1},{-1,0},{-1,1},{0,-1},{0,1},{1,-1},{1,0},{1,1}};
-    for (auto d : king_deltas) { if (getPieceAt(state, r + d.first, c + d.second) == attacking_king) return true; }
-    return false;
+    Bitboard occupied = state.occupancy[0] | state.occupancy[1];
+    return (attackersTo(state, r * 8 + c, occupied) & state.occupancy[byWhiteAttacker ? 0 : 1]) != 0;
 }
 
 // Check if king is in check
 bool isKingInCheck(const BoardState& state, bool kingIsWhite) {
-    int kr = -1, kc = -1; char k_char = kingIsWhite ? W_KING : B_KING;
-    for (int r = 0; r < 8 && kr == -1; ++r) { for (int c = 0; c < 8; ++c) { if (state.board[r][c] == k_char) { kr = r; kc = c; break; } } }
-    return (kr != -1) && isSquareAttacked(state, kr, kc, !kingIsWhite);
+    Bitboard king = state.pieceBB[kingIsWhite ? 5 : 11];
+    if (!king) return false;
+    int sq = lsbIndex(king);
+    return isSquareAttacked(state, sq / 8, sq % 8, !kingIsWhite);
 }
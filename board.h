@@ -2,6 +2,8 @@
 #define BOARD_H
 
 #include "types.h"
+#include <string>
+#include <vector>
 
 // Helper functions
 bool isSquareOnBoard(int r, int c);
@@ -9,6 +11,42 @@ char getPieceAt(const BoardState& state, int r, int c);
 bool isWhitePiece(char piece);
 bool isBlackPiece(char piece);
 
+// Piece index (0-5 white P,N,B,R,Q,K; 6-11 black) for piece-indexed tables, -1 for EMPTY
+inline int pieceIndex(char piece) {
+    switch (piece) {
+        case W_PAWN: return 0; case W_KNIGHT: return 1; case W_BISHOP: return 2;
+        case W_ROOK: return 3; case W_QUEEN: return 4; case W_KING: return 5;
+        case B_PAWN: return 6; case B_KNIGHT: return 7; case B_BISHOP: return 8;
+        case B_ROOK: return 9; case B_QUEEN: return 10; case B_KING: return 11;
+        default: return -1;
+    }
+}
+
+// Material key: a 4-bit count per piece index, so equal keys mean equal material
+inline uint64_t materialKeyUnit(int piece) { return 1ULL << (4 * piece); }
+inline int materialCount(uint64_t materialKey, int piece) { return (int)((materialKey >> (4 * piece)) & 15); }
+
+// Zobrist hashing
+extern uint64_t zobristPieces[12][64];
+extern uint64_t zobristSide;
+extern uint64_t zobristCastling[16];
+extern uint64_t zobristEnPassant[8];
+void initZobrist();
+uint64_t computeHashKey(const BoardState& state);
+uint64_t computePawnKey(const BoardState& state);
+void computeIncrementalState(BoardState& state);
+
+// Game history for repetition detection: Zobrist keys of the positions reached in the game,
+// kept outside BoardState so that copying a position never allocates. Maintained by the UCI
+// position command; positions inside the search are not added.
+extern std::vector<uint64_t> gameHistory;
+int repetitionCount(uint64_t hashKey);
+
+// Whether parseFen can set up a legal-looking position from 'fen': 8 ranks of 8 squares,
+// one king per side, no pawns on the back ranks, and well-formed side, castling, en passant
+// and clock fields. For FENs from untrusted input (parseFen assumes a valid string).
+bool isValidFen(const std::string& fen);
+
 // Board state manipulation
 void apply_raw_move_to_board(BoardState& state, const Move& move);
 
@@ -1,12 +1,19 @@
 #include "book.h"
 #include "board.h"
 #include "movegen.h"
+#include "polyglot.h"
 #include "constants.h"
 #include <fstream>
 #include <sstream>
 #include <random>
 #include <algorithm>
 #include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // Global opening book instance
 OpeningBook globalBook;
@@ -14,61 +21,18 @@ OpeningBook globalBook;
 // External RNG (defined in uci.cpp)
 extern std::mt19937 global_rng;
 
-OpeningBook::OpeningBook() {
+OpeningBook::OpeningBook() : polyglotEntries(nullptr), polyglotEntryCount(0), mappedBytes(0) {
     // Constructor - book starts empty
 }
 
-// Get simplified position key for book lookup
-// Format: board position + side to move + castling rights + en passant
-// Excludes halfmove and fullmove counters (they don't affect position)
-std::string OpeningBook::getBookKey(const BoardState& state) const {
-    std::string key;
-
-    // Board position (8 ranks)
-    for (int r = 0; r < 8; ++r) {
-        int emptyCount = 0;
-        for (int c = 0; c < 8; ++c) {
-            char piece = state.board[r][c];
-            if (piece == EMPTY) {
-                emptyCount++;
-            } else {
-                if (emptyCount > 0) {
-                    key += std::to_string(emptyCount);
-                    emptyCount = 0;
-                }
-                key += piece;
-            }
-        }
-        if (emptyCount > 0) {
-            key += std::to_string(emptyCount);
-        }
-        if (r < 7) key += '/';
-    }
+OpeningBook::~OpeningBook() { clear(); }
 
-    // Side to move
-    key += ' ';
-    key += state.whiteToMove ? 'w' : 'b';
-
-    // Castling rights
-    key += ' ';
-    std::string castling;
-    if (state.whiteKingSideCastle) castling += 'K';
-    if (state.whiteQueenSideCastle) castling += 'Q';
-    if (state.blackKingSideCastle) castling += 'k';
-    if (state.blackQueenSideCastle) castling += 'q';
-    if (castling.empty()) castling = "-";
-    key += castling;
-
-    // En passant target
-    key += ' ';
-    if (state.enPassantTarget.first == -1) {
-        key += '-';
-    } else {
-        key += (char)('a' + state.enPassantTarget.second);
-        key += (char)('8' - state.enPassantTarget.first);
-    }
-
-    return key;
+void OpeningBook::clear() {
+    bookMoves.clear();
+    if (polyglotEntries) munmap(const_cast<unsigned char*>(polyglotEntries), mappedBytes);
+    polyglotEntries = nullptr;
+    polyglotEntryCount = 0;
+    mappedBytes = 0;
 }
 
 // Parse a single line from the book file
@@ -86,10 +50,10 @@ void OpeningBook::parseBookLine(const std::string& line) {
     // Parse FEN to get book key
     BoardState tempState;
     tempState.parseFen(fen);
-    std::string key = getBookKey(tempState);
+    uint64_t key = polyglotKey(tempState);
 
-    // Parse moves (comma-separated)
-    std::vector<std::string> moves;
+    // Parse moves (comma-separated) and append them to the position's moves
+    std::vector<std::string>& moves = bookMoves[key];
     std::istringstream iss(movesStr);
     std::string move;
     while (std::getline(iss, move, ',')) {
@@ -100,28 +64,25 @@ void OpeningBook::parseBookLine(const std::string& line) {
             moves.push_back(move);
         }
     }
-
-    // Add to book (append if key already exists)
-    if (!moves.empty()) {
-        if (bookMoves.find(key) == bookMoves.end()) {
-            bookMoves[key] = moves;
-        } else {
-            // Append new moves to existing ones
-            bookMoves[key].insert(bookMoves[key].end(), moves.begin(), moves.end());
-        }
-    }
+    if (moves.empty()) bookMoves.erase(key);
 }
 
 // Load opening book from file
 bool OpeningBook::loadFromFile(const std::string& filename) {
+    clear(); // Clear existing book
+    if (filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".bin") == 0) {
+        return loadPolyglotFile(filename);
+    }
+    return loadTextFile(filename);
+}
+
+bool OpeningBook::loadTextFile(const std::string& filename) {
     std::ifstream file(filename);
     if (!file.is_open()) {
         std::cerr << "Warning: Could not open opening book file: " << filename << std::endl;
         return false;
     }
 
-    clear(); // Clear existing book
-
     std::string line;
     int lineCount = 0;
     while (std::getline(file, line)) {
@@ -136,30 +97,105 @@ bool OpeningBook::loadFromFile(const std::string& filename) {
     return true;
 }
 
-// Probe the book for a move
-bool OpeningBook::probeBook(const BoardState& state, Move& move) const {
-    std::string key = getBookKey(state);
-
-    auto it = bookMoves.find(key);
-    if (it == bookMoves.end()) {
-        return false; // Position not in book
+// Map the file read-only; entries are read in place by probes
+bool OpeningBook::loadPolyglotFile(const std::string& filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Warning: Could not open opening book file: " << filename << std::endl;
+        return false;
     }
-
-    const std::vector<std::string>& moves = it->second;
-    if (moves.empty()) {
-        return false; // No moves for this position
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0 || st.st_size % POLYGLOT_ENTRY_BYTES != 0) {
+        std::cerr << "Warning: Not a Polyglot book (size is not a multiple of " << POLYGLOT_ENTRY_BYTES
+                  << " bytes): " << filename << std::endl;
+        close(fd);
+        return false;
+    }
+    size_t bytes = (size_t)st.st_size;
+    void* map = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << "Warning: Could not map opening book " << filename << ": " << std::strerror(errno) << std::endl;
+        return false;
     }
+    // Probes jump around the file: do not read ahead
+    madvise(map, bytes, MADV_RANDOM);
+    polyglotEntries = static_cast<const unsigned char*>(map);
+    polyglotEntryCount = bytes / POLYGLOT_ENTRY_BYTES;
+    mappedBytes = bytes;
+
+    std::cerr << "Loaded opening book: " << polyglotEntryCount << " Polyglot entries from " << filename << std::endl;
+    return true;
+}
+
+// Probe the book for a move
+bool OpeningBook::probeBook(const BoardState& state, Move& move) const {
+    if (!polyglotEntries && bookMoves.empty()) return false;
 
     // Generate legal moves to validate book move
-    std::vector<Move> legalMoves;
+    MoveList legalMoves;
     generateLegalMoves(state, legalMoves, false);
     if (legalMoves.empty()) {
         return false; // No legal moves (shouldn't happen)
     }
+    return polyglotEntries ? probePolyglot(state, legalMoves, move) : probeText(state, legalMoves, move);
+}
+
+bool OpeningBook::probePolyglot(const BoardState& state, const MoveList& legalMoves, Move& move) const {
+    uint64_t key = polyglotKey(state);
+
+    // First entry with this key (entries are sorted by key)
+    size_t low = 0, high = polyglotEntryCount;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (readPolyglotEntry(polyglotEntries + mid * POLYGLOT_ENTRY_BYTES).key < key) low = mid + 1;
+        else high = mid;
+    }
+
+    // The position's legal book moves and their weights
+    Move candidates[MAX_MOVES];
+    uint32_t weights[MAX_MOVES];
+    int candidateCount = 0;
+    uint64_t totalWeight = 0;
+    for (size_t i = low; i < polyglotEntryCount && candidateCount < MAX_MOVES; ++i) {
+        PolyglotEntry entry = readPolyglotEntry(polyglotEntries + i * POLYGLOT_ENTRY_BYTES);
+        if (entry.key != key) break;
+        for (const Move& legalMove : legalMoves) {
+            if (encodePolyglotMove(legalMove) == entry.move) {
+                candidates[candidateCount] = legalMove;
+                weights[candidateCount++] = entry.weight;
+                totalWeight += entry.weight;
+                break;
+            }
+        }
+    }
+    if (candidateCount == 0) return false;
+
+    // Weighted choice; a position whose moves all have weight 0 picks uniformly
+    if (totalWeight == 0) {
+        std::uniform_int_distribution<int> pick(0, candidateCount - 1);
+        move = candidates[pick(global_rng)];
+        return true;
+    }
+    std::uniform_int_distribution<uint64_t> pick(0, totalWeight - 1);
+    uint64_t target = pick(global_rng);
+    for (int i = 0; i < candidateCount; ++i) {
+        if (target < weights[i]) { move = candidates[i]; return true; }
+        target -= weights[i];
+    }
+    move = candidates[candidateCount - 1];
+    return true;
+}
+
+bool OpeningBook::probeText(const BoardState& state, const MoveList& legalMoves, Move& move) const {
+    auto it = bookMoves.find(polyglotKey(state));
+    if (it == bookMoves.end()) {
+        return false; // Position not in book
+    }
 
     // Try to find a valid book move
     // Shuffle the book moves for variety
-    std::vector<std::string> shuffledMoves = moves;
+    std::vector<std::string> shuffledMoves = it->second;
     std::shuffle(shuffledMoves.begin(), shuffledMoves.end(), global_rng);
 
     for (const std::string& bookMoveStr : shuffledMoves) {
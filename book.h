@@ -2,29 +2,49 @@
 #define BOOK_H
 
 #include "types.h"
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
-#include <map>
 
 // Opening Book System
-// Simple text-based format: Each line is "FEN,move1,move2,move3"
-// Supports multiple moves per position for variety
+// Two formats, chosen by file extension:
+// - Polyglot ".bin" books (see polyglot.h) are memory-mapped as they are: loading reads
+//   nothing, and a probe binary-searches the sorted entries and picks one of the
+//   position's moves with probability proportional to its weight.
+// - Text books, one "FEN,move1,move2,move3" line per position, for small hand-written
+//   books. Each listed move is equally likely.
+// Both are keyed by the position's Polyglot key.
+
+// Loaded at "uci" unless the BookFile option names another book
+const char DEFAULT_BOOK_FILE[] = "opening_book.txt";
 
 class OpeningBook {
 private:
-    // Map from position key (simplified FEN) to vector of book moves
-    std::map<std::string, std::vector<std::string>> bookMoves;
+    // Text book: moves by Polyglot key
+    std::unordered_map<uint64_t, std::vector<std::string>> bookMoves;
 
-    // Helper function to normalize position key (FEN without move counters)
-    std::string getBookKey(const BoardState& state) const;
+    // Polyglot book: the mapped file
+    const unsigned char* polyglotEntries;
+    size_t polyglotEntryCount;
+    size_t mappedBytes;
 
     // Helper function to parse a book line
     void parseBookLine(const std::string& line);
 
+    bool loadTextFile(const std::string& filename);
+    bool loadPolyglotFile(const std::string& filename);
+    bool probePolyglot(const BoardState& state, const MoveList& legalMoves, Move& move) const;
+    bool probeText(const BoardState& state, const MoveList& legalMoves, Move& move) const;
+
 public:
     OpeningBook();
+    ~OpeningBook();
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
 
-    // Load opening book from file
+    // Load opening book from file (Polyglot if it ends in ".bin", text otherwise)
     // Returns true if successful, false otherwise
     bool loadFromFile(const std::string& filename);
 
@@ -33,11 +53,11 @@ public:
     // Returns false if position not in book
     bool probeBook(const BoardState& state, Move& move) const;
 
-    // Get number of positions in book
-    int size() const { return bookMoves.size(); }
+    // Number of positions (text) or entries (Polyglot) in the book
+    size_t size() const { return polyglotEntries ? polyglotEntryCount : bookMoves.size(); }
 
     // Clear the book
-    void clear() { bookMoves.clear(); }
+    void clear();
 };
 
 // Global opening book instance
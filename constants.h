@@ -1,35 +1,29 @@
 #ifndef CONSTANTS_H
 #define CONSTANTS_H
 
-#include <map>
+#include <cstdint>
+#include <cstddef>
 
 // Piece character constants
 const char EMPTY = ' ';
 const char W_PAWN = 'P', W_KNIGHT = 'N', W_BISHOP = 'B', W_ROOK = 'R', W_QUEEN = 'Q', W_KING = 'K';
 const char B_PAWN = 'p', B_KNIGHT = 'n', B_BISHOP = 'b', B_ROOK = 'r', B_QUEEN = 'q', B_KING = 'k';
 
+// Piece tables are indexed by piece type: pieceIndex(piece) % 6 (P, N, B, R, Q, K)
+const int PIECE_TYPE_COUNT = 6;
+
 // Piece values for material evaluation (in centipawns)
-const std::map<char, int> piece_values = {
-    {W_PAWN, 100}, {B_PAWN, 100},
-    {W_KNIGHT, 320}, {B_KNIGHT, 320},
-    {W_BISHOP, 330}, {B_BISHOP, 330},
-    {W_ROOK, 500}, {B_ROOK, 500},
-    {W_QUEEN, 900}, {B_QUEEN, 900},
-    {W_KING, 20000}, {B_KING, 20000}
-};
+constexpr int piece_values[PIECE_TYPE_COUNT] = {100, 320, 330, 500, 900, 20000};
 
 // Simplified piece values for MVV-LVA (less granularity needed)
-const std::map<char, int> mvv_lva_piece_values = {
-    {W_PAWN, 1}, {B_PAWN, 1},
-    {W_KNIGHT, 3}, {B_KNIGHT, 3},
-    {W_BISHOP, 3}, {B_BISHOP, 3},
-    {W_ROOK, 5}, {B_ROOK, 5},
-    {W_QUEEN, 9}, {B_QUEEN, 9},
-    {W_KING, 10}, {B_KING, 10}
-};
+constexpr int mvv_lva_piece_values[PIECE_TYPE_COUNT] = {1, 3, 3, 5, 9, 10};
+
+// Game phase weights; the phase is clamped to TOTAL_PHASE (opening) and falls to 0 with bare kings
+constexpr int phase_weights[PIECE_TYPE_COUNT] = {0, 1, 1, 2, 4, 0};
+const int TOTAL_PHASE = 24;
 
 // Piece-Square Tables (PSTs)
-const int pawn_pst[64] = {
+constexpr int pawn_pst[64] = {
     0,0,0,0,0,0,0,0,
     50,50,50,50,50,50,50,50,
     10,10,20,30,30,20,10,10,
@@ -40,7 +34,7 @@ const int pawn_pst[64] = {
     0,0,0,0,0,0,0,0
 };
 
-const int knight_pst[64] = {
+constexpr int knight_pst[64] = {
     -50,-40,-30,-30,-30,-30,-40,-50,
     -40,-20,0,0,0,0,-20,-40,
     -30,0,10,15,15,10,0,-30,
@@ -51,7 +45,7 @@ const int knight_pst[64] = {
     -50,-40,-30,-30,-30,-30,-40,-50
 };
 
-const int bishop_pst[64] = {
+constexpr int bishop_pst[64] = {
     -20,-10,-10,-10,-10,-10,-10,-20,
     -10,0,0,0,0,0,0,-10,
     -10,0,5,10,10,5,0,-10,
@@ -62,7 +56,7 @@ const int bishop_pst[64] = {
     -20,-10,-10,-10,-10,-10,-10,-20
 };
 
-const int rook_pst[64] = {
+constexpr int rook_pst[64] = {
     0,0,0,0,0,0,0,0,
     5,10,10,10,10,10,10,5,
     -5,0,0,0,0,0,0,-5,
@@ -73,7 +67,7 @@ const int rook_pst[64] = {
     0,0,0,5,5,0,0,0
 };
 
-const int queen_pst[64] = {
+constexpr int queen_pst[64] = {
     -20,-10,-10,-5,-5,-10,-10,-20,
     -10,0,0,0,0,0,0,-10,
     -10,0,5,5,5,5,0,-10,
@@ -84,7 +78,7 @@ const int queen_pst[64] = {
     -20,-10,-10,-5,-5,-10,-10,-20
 };
 
-const int king_pst_mg[64] = {
+constexpr int king_pst_mg[64] = {
     -30,-40,-40,-50,-50,-40,-40,-30,
     -30,-40,-40,-50,-50,-40,-40,-30,
     -30,-40,-40,-50,-50,-40,-40,-30,
@@ -95,7 +89,7 @@ const int king_pst_mg[64] = {
     20,30,10,0,0,10,30,20
 };
 
-const int king_pst_eg[64] = {
+constexpr int king_pst_eg[64] = {
     -50,-40,-30,-20,-20,-30,-40,-50,
     -30,-20,-10,0,0,-10,-20,-30,
     -30,-10,20,30,30,20,-10,-30,
@@ -106,19 +100,61 @@ const int king_pst_eg[64] = {
     -50,-30,-30,-30,-30,-30,-30,-50
 };
 
+// Piece-square tables by piece type for the middlegame and the endgame (only the king differs)
+constexpr const int* pst_mg[PIECE_TYPE_COUNT] = {pawn_pst, knight_pst, bishop_pst, rook_pst, queen_pst, king_pst_mg};
+constexpr const int* pst_eg[PIECE_TYPE_COUNT] = {pawn_pst, knight_pst, bishop_pst, rook_pst, queen_pst, king_pst_eg};
+
+// Material + PST contribution of piece index p (0-11) on square sq, from white's perspective.
+// Tables are written for white; black squares are mirrored vertically (sq ^ 56).
+constexpr int pieceSquareMg(int p, int sq) {
+    return p < 6 ? piece_values[p] + pst_mg[p][sq] : -(piece_values[p - 6] + pst_mg[p - 6][sq ^ 56]);
+}
+constexpr int pieceSquareEg(int p, int sq) {
+    return p < 6 ? piece_values[p] + pst_eg[p][sq] : -(piece_values[p - 6] + pst_eg[p - 6][sq ^ 56]);
+}
+
 // Evaluation scores for terminal states
 const int MATE_SCORE = 100000;
 const int DRAW_SCORE = 0;
 const int MAX_SEARCH_PLY = 64;
 const int MAX_QUIESCENCE_PLY = 6;
-const int IN_CHECK_PENALTY = 50;
+const int MAX_MOVES = 256; // Capacity of a MoveList (at most 218 legal moves in any position)
+const int DELTA_PRUNING_MARGIN = 200; // Quiescence: skip captures that cannot lift the score to alpha
 const int LMR_REDUCTION = 1;
 const int LMR_MIN_MOVES_TO_TRY_REDUCTION = 3;
 const int LMR_MIN_DEPTH_FOR_REDUCTION = 3;
 const int CHECK_EXTENSION_PLY = 1;
 
-// Transposition Table
-const size_t MAX_TT_SIZE = 1000000;
+// Transposition Table (size in MB, set with the UCI Hash option)
+const size_t DEFAULT_TT_SIZE_MB = 64;
+const size_t MAX_TT_SIZE_MB = 4096;
+const int TT_BUCKET_SIZE = 4;
+const int TT_AGE_WEIGHT = 8;
+const int TT_DEPTH_QSEARCH = 0; // Depth of quiescence search entries
+const char TT_FILE_MAGIC[8] = {'G','O','T','H','A','M','T','T'};
+const uint32_t TT_FILE_VERSION = 2;
+const uint32_t TT_FILE_BYTE_ORDER = 0x01020304;
+const size_t TT_SHARED_HEADER_BYTES = 4096;
+const char DEFAULT_SHARED_TT_NAME[] = "/gotham_tt";
+const int TT_SHARED_ATTACH_TIMEOUT_MS = 2000;
+const char TT_SHARED_LOCK_DIR[] = "/tmp"; // Holds "<Shared Hash Name>.lock"
+const size_t TT_LARGE_PAGE_BYTES = 2 * 1024 * 1024; // Huge page size assumed for alignment
+
+// Evaluation cache (entries, power of two; 8 bytes each)
+const size_t EVAL_CACHE_SIZE = 1 << 16;
+
+// NNUE network shape and file format (see nnue.h)
+const int NNUE_INPUTS = 768;
+const int NNUE_HIDDEN = 256;
+const int NNUE_ACTIVATION_MAX = 127;
+const int NNUE_OUTPUT_DIVISOR = 127 * 64;
+const char NNUE_FILE_MAGIC[8] = {'G','O','T','H','N','N','U','E'};
+const uint32_t NNUE_FILE_VERSION = 1;
+const size_t NNUE_ACCUMULATOR_CACHE_SIZE = 1024; // Cached accumulators (power of two, 1 KB each)
+
+// Endgame bitbase file format (see bitbase.h)
+const char BITBASE_FILE_MAGIC[8] = {'G','O','T','H','B','B','A','S'};
+const uint32_t BITBASE_FILE_VERSION = 1;
 
 // Null Move Pruning
 const int NULL_MOVE_REDUCTION = 2;
@@ -131,6 +167,13 @@ const int NUM_KILLER_MOVES = 2;
 const int KILLER_MOVE_1_SCORE = 900;
 const int KILLER_MOVE_2_SCORE = 800;
 const int HISTORY_SCORE_DIVISOR = 100;
+const int COUNTER_MOVE_SCORE = 20;
+const int CAPTURE_HISTORY_DIVISOR = 1000;
+
+// History tables (bounded by a gravity update, halved between searches)
+const int HISTORY_MAX = 16384;
+const int HISTORY_BONUS_MAX = 1200;
+const int MAX_TRIED_MOVES = 64;
 
 // Aspiration Windows
 const int ASPIRATION_WINDOW = 50;
@@ -140,11 +183,13 @@ const int ASPIRATION_MIN_DEPTH = 3;
 enum TTEntryFlag { TT_EXACT, TT_LOWERBOUND, TT_UPPERBOUND, TT_INVALID };
 
 struct TTEntry {
-    int score;
-    int depth;
-    TTEntryFlag flag;
+    uint64_t key;
+    int32_t score;
+    int16_t depth;
+    uint8_t flag;       // TTEntryFlag
+    uint8_t generation; // Search generation that wrote the entry
 
-    TTEntry() : score(0), depth(-1), flag(TT_INVALID) {}
+    TTEntry() : key(0), score(0), depth(-1), flag(TT_INVALID), generation(0) {}
 };
 
 #endif // CONSTANTS_H
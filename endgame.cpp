@@ -0,0 +1,132 @@
+#include "endgame.h"
+#include "board.h"
+#include "constants.h"
+#include "bitbase.h"
+#include "attacks.h"
+#include <algorithm>
+#include <cstdlib>
+
+// Piece squares used by the endgame evaluators, with rows flipped for a black strong
+// side so that the strong side always promotes towards row 0
+struct EndgameSquares {
+    int strongKingRow, strongKingCol;
+    int weakKingRow, weakKingCol;
+    int pieceRow[12], pieceCol[12]; // Last piece of each index found (-1 if none)
+};
+
+static EndgameSquares findSquares(const BoardState& state, int strongSide) {
+    EndgameSquares sq;
+    std::fill(sq.pieceRow, sq.pieceRow + 12, -1);
+    std::fill(sq.pieceCol, sq.pieceCol + 12, -1);
+    for (int r = 0; r < 8; ++r) {
+        for (int c = 0; c < 8; ++c) {
+            int p = pieceIndex(state.board[r][c]);
+            if (p < 0) continue;
+            int row = (strongSide == 0) ? r : 7 - r;
+            sq.pieceRow[p] = row;
+            sq.pieceCol[p] = c;
+        }
+    }
+    int strongKing = strongSide * 6 + 5, weakKing = (strongSide ^ 1) * 6 + 5;
+    sq.strongKingRow = sq.pieceRow[strongKing]; sq.strongKingCol = sq.pieceCol[strongKing];
+    sq.weakKingRow = sq.pieceRow[weakKing]; sq.weakKingCol = sq.pieceCol[weakKing];
+    return sq;
+}
+
+static int distance(int r1, int c1, int r2, int c2) { return squareDistance[r1 * 8 + c1][r2 * 8 + c2]; }
+
+// 0 in the centre, 6 in a corner
+static int centreDistance(int r, int c) { return (r < 4 ? 3 - r : r - 4) + (c < 4 ? 3 - c : c - 4); }
+
+// Non-king material of one side
+static int sideMaterial(const BoardState& state, int side) {
+    int material = 0;
+    for (int type = 0; type < 5; ++type) material += materialCount(state.materialKey, side * 6 + type) * piece_values[type];
+    return material;
+}
+
+static int fromWhite(int score, int strongSide) { return strongSide == 0 ? score : -score; }
+
+int evaluateKnownWin(const BoardState& state, int strongSide) {
+    EndgameSquares sq = findSquares(state, strongSide);
+    int score = sideMaterial(state, strongSide) - sideMaterial(state, strongSide ^ 1) + ENDGAME_KNOWN_WIN;
+    score += ENDGAME_PUSH_TO_EDGE * centreDistance(sq.weakKingRow, sq.weakKingCol);
+    score += ENDGAME_PUSH_CLOSE * (7 - distance(sq.strongKingRow, sq.strongKingCol, sq.weakKingRow, sq.weakKingCol));
+    return fromWhite(score, strongSide);
+}
+
+int evaluateKXK(const BoardState& state, int strongSide) {
+    // KQK / KRK positions where the piece is lost or the defender is stalemated
+    if (probeBitbase(state) == BITBASE_DRAW) return DRAW_SCORE;
+    return evaluateKnownWin(state, strongSide);
+}
+
+int evaluateKBBK(const BoardState& state, int strongSide) {
+    Bitboard bishops = state.pieceBB[strongSide * 6 + 2];
+    if (!(bishops & LIGHT_SQUARES_BB) || !(bishops & ~LIGHT_SQUARES_BB)) return DRAW_SCORE;
+    return evaluateKXK(state, strongSide);
+}
+
+int evaluateKBNK(const BoardState& state, int strongSide) {
+    EndgameSquares sq = findSquares(state, strongSide);
+    int bishop = strongSide * 6 + 2;
+    // Work in real board rows here: square colours do not survive the row flip
+    int bishopRow = (strongSide == 0) ? sq.pieceRow[bishop] : 7 - sq.pieceRow[bishop];
+    bool lightBishop = ((bishopRow + sq.pieceCol[bishop]) & 1) == 0;
+    int wr = (strongSide == 0) ? sq.weakKingRow : 7 - sq.weakKingRow, wc = sq.weakKingCol;
+    // Light corners (a8, h1) are rows/cols (0,0) and (7,7); dark corners (h8, a1) are (0,7) and (7,0)
+    int cornerDist = lightBishop ? std::min(distance(wr, wc, 0, 0), distance(wr, wc, 7, 7))
+                                 : std::min(distance(wr, wc, 0, 7), distance(wr, wc, 7, 0));
+    int score = sideMaterial(state, strongSide) + ENDGAME_KNOWN_WIN;
+    score += ENDGAME_PUSH_TO_CORNER * (7 - cornerDist);
+    score += ENDGAME_PUSH_CLOSE * (7 - distance(sq.strongKingRow, sq.strongKingCol, sq.weakKingRow, sq.weakKingCol));
+    return fromWhite(score, strongSide);
+}
+
+// KPK from the bitbase; the rules (pawn lost, rule of the square, key squares, defender
+// in front of the pawn) are the fallback when it has not been built
+int evaluateKPK(const BoardState& state, int strongSide) {
+    EndgameSquares sq = findSquares(state, strongSide);
+    int pawn = strongSide * 6;
+    int pr = sq.pieceRow[pawn], pc = sq.pieceCol[pawn];
+    bool strongToMove = state.whiteToMove == (strongSide == 0);
+    int pawnSteps = (pr == 6) ? 5 : pr;
+    bool rookPawn = (pc == 0 || pc == 7);
+    int winScore = ENDGAME_KNOWN_WIN + piece_values[0] + ENDGAME_PAWN_STEP * (6 - pawnSteps);
+
+    BitbaseResult known = probeBitbase(state);
+    if (known == BITBASE_DRAW) return DRAW_SCORE;
+    if (known != BITBASE_UNKNOWN) return fromWhite(winScore, strongSide);
+
+    // The defender takes the pawn
+    if (!strongToMove && distance(sq.weakKingRow, sq.weakKingCol, pr, pc) == 1 &&
+        distance(sq.strongKingRow, sq.strongKingCol, pr, pc) > 1) return DRAW_SCORE;
+
+    // Rule of the square (the strong king must not block its own pawn)
+    bool kingInPath = sq.strongKingCol == pc && sq.strongKingRow < pr;
+    int defenderSteps = distance(sq.weakKingRow, sq.weakKingCol, 0, pc) - (strongToMove ? 0 : 1);
+    if (!kingInPath && defenderSteps > pawnSteps) return fromWhite(winScore, strongSide);
+
+    // Strong king on a key square of a non-rook pawn
+    if (!rookPawn && std::abs(sq.strongKingCol - pc) <= 1) {
+        int keyRowFar = std::max(pr - 2, 0);
+        int keyRowNear = (pr <= 3) ? pr - 1 : keyRowFar;
+        if (sq.strongKingRow == keyRowFar || sq.strongKingRow == keyRowNear) return fromWhite(winScore, strongSide);
+    }
+
+    // Defender in front of the pawn, or in the promotion corner of a rook pawn
+    if (sq.weakKingCol == pc && sq.weakKingRow < pr) return DRAW_SCORE;
+    if (rookPawn && distance(sq.weakKingRow, sq.weakKingCol, 0, pc) <= 1) return DRAW_SCORE;
+
+    return fromWhite(piece_values[0] + ENDGAME_PAWN_STEP * (6 - pawnSteps), strongSide);
+}
+
+int scaleOppositeBishops(const BoardState& state, int strongSide) {
+    EndgameSquares sq = findSquares(state, 0);
+    int whiteColour = (sq.pieceRow[2] + sq.pieceCol[2]) & 1;
+    int blackColour = (sq.pieceRow[8] + sq.pieceCol[8]) & 1;
+    if (whiteColour == blackColour) return SCALE_FACTOR_NORMAL;
+    int strongPawns = materialCount(state.materialKey, strongSide * 6);
+    int weakPawns = materialCount(state.materialKey, (strongSide ^ 1) * 6);
+    return (strongPawns - weakPawns <= 1) ? SCALE_FACTOR_NORMAL / 4 : SCALE_FACTOR_NORMAL / 2;
+}
@@ -0,0 +1,42 @@
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include "types.h"
+
+// Specialised endgame evaluation
+// Evaluators replace the normal evaluation for material configurations with known
+// technique; scale functions shrink the normal evaluation towards a draw.
+// 'strongSide' is 0 for white, 1 for black.
+
+// Scale factors are out of SCALE_FACTOR_NORMAL
+const int SCALE_FACTOR_NORMAL = 64;
+const int SCALE_FACTOR_DRAW = 0;
+
+// Endgame evaluation constants (in centipawns)
+const int ENDGAME_KNOWN_WIN = 1000;      // Added to won material configurations
+const int ENDGAME_PUSH_TO_EDGE = 20;     // Per step of the weak king away from the centre
+const int ENDGAME_PUSH_CLOSE = 10;       // Per step the kings are closer together
+const int ENDGAME_PUSH_TO_CORNER = 30;   // KBNK: per step closer to a corner of the bishop's colour
+const int ENDGAME_PAWN_STEP = 20;        // KPK: per step the pawn has advanced
+
+// Returns the score from white's perspective
+typedef int (*EndgameEvalFn)(const BoardState& state, int strongSide);
+// Returns a scale factor for the strong side's advantage
+typedef int (*EndgameScaleFn)(const BoardState& state, int strongSide);
+
+// Won ending (from a bitbase): material, weak king to the edge, kings close together
+int evaluateKnownWin(const BoardState& state, int strongSide);
+// King and mating material against a bare king (KQK, KRK, KBNNK, ...)
+int evaluateKXK(const BoardState& state, int strongSide);
+// King, bishop and knight against a bare king: mate in the corner of the bishop's colour
+int evaluateKBNK(const BoardState& state, int strongSide);
+// King and pawn against king
+int evaluateKPK(const BoardState& state, int strongSide);
+// King and two or more bishops (nothing else) against a bare king: drawn if the bishops are
+// all on one colour, otherwise KXK
+int evaluateKBBK(const BoardState& state, int strongSide);
+
+// Bishops of opposite colours with only pawns besides
+int scaleOppositeBishops(const BoardState& state, int strongSide);
+
+#endif // ENDGAME_H
@@ -2,61 +2,150 @@
 #include "board.h"
 #include "constants.h"
 #include "pawn_structure.h"
-#include <cctype>
-
-// Evaluate the board position from white's perspective
-int evaluateBoard(const BoardState& state) {
-    int score = 0;
-    int total_material_no_kings = 0;
-
-    for(int r=0; r<8; ++r) {
-        for(int c=0; c<8; ++c) {
-            char piece = state.board[r][c];
-            if(piece!=EMPTY) {
-                auto it = piece_values.find(piece);
-                int piece_val = 0;
-                if(it != piece_values.end()) piece_val = it->second;
-
-                if (toupper(piece) != W_KING) {
-                    auto mat_it = piece_values.find(toupper(piece));
-                    if (mat_it != piece_values.end()) total_material_no_kings += mat_it->second;
-                }
-
-                int pst_bonus = 0;
-                int square_index = r * 8 + c;
-                int black_square_index = (7 - r) * 8 + c;
-
-                if (isWhitePiece(piece)) {
-                    score += piece_val;
-                    if (piece == W_PAWN) pst_bonus = pawn_pst[square_index];
-                    else if (piece == W_KNIGHT) pst_bonus = knight_pst[square_index];
-                    else if (piece == W_BISHOP) pst_bonus = bishop_pst[square_index];
-                    else if (piece == W_ROOK) pst_bonus = rook_pst[square_index];
-                    else if (piece == W_QUEEN) pst_bonus = queen_pst[square_index];
-                    else if (piece == W_KING) {
-                        if (total_material_no_kings < 1500) pst_bonus = king_pst_eg[square_index];
-                        else pst_bonus = king_pst_mg[square_index];
-                    }
-                    score += pst_bonus;
-                } else {
-                    score -= piece_val;
-                    if (piece == B_PAWN) pst_bonus = pawn_pst[black_square_index];
-                    else if (piece == B_KNIGHT) pst_bonus = knight_pst[black_square_index];
-                    else if (piece == B_BISHOP) pst_bonus = bishop_pst[black_square_index];
-                    else if (piece == B_ROOK) pst_bonus = rook_pst[black_square_index];
-                    else if (piece == B_QUEEN) pst_bonus = queen_pst[black_square_index];
-                    else if (piece == B_KING) {
-                        if (total_material_no_kings < 1500) pst_bonus = king_pst_eg[black_square_index];
-                        else pst_bonus = king_pst_mg[black_square_index];
-                    }
-                    score -= pst_bonus;
-                }
+#include "nnue.h"
+#include "material.h"
+#include "endgame.h"
+#include "bitbase.h"
+#include "attacks.h"
+#include "profile.h"
+#include <algorithm>
+#include <atomic>
+
+static bool nnueEnabled = false;
+static std::atomic<uint64_t> lazyEvalExits(0);
+
+void setUseNnue(bool enable) {
+    nnueEnabled = enable && nnueLoaded();
+    clearEvalCache();
+}
+
+bool usingNnue() { return nnueEnabled; }
+
+// Mobility of knights, bishops, rooks and queens over squares not held by own pieces or
+// attacked by enemy pawns (within +/-MOBILITY_MAX), and attacks on the king zone (middlegame
+// only, while the attacker has a queen). Returns white's score tapered by 'phase'.
+static int evaluateAttacks(const BoardState& state, const AttackInfo& info, int phase) {
+    int mg = 0, eg = 0;
+    for (int side = 0; side < 2; side++) {
+        int sign = side == 0 ? 1 : -1, them = side ^ 1;
+        Bitboard mobilityArea = ~state.occupancy[side] & ~info.byType[them][0];
+        for (int type = 1; type <= 4; type++) {
+            for (Bitboard b = state.pieceBB[side * 6 + type]; b; ) {
+                int squares = popCount(info.attacksFrom[popLsb(b)] & mobilityArea) - MOBILITY_BASELINE[type];
+                mg += sign * squares * MOBILITY_MG[type];
+                eg += sign * squares * MOBILITY_EG[type];
             }
         }
     }
+    mg = std::max(-MOBILITY_MAX, std::min(mg, MOBILITY_MAX));
+    eg = std::max(-MOBILITY_MAX, std::min(eg, MOBILITY_MAX));
+
+    for (int side = 0; side < 2; side++) {
+        int sign = side == 0 ? 1 : -1, them = side ^ 1;
+
+        if (!state.pieceBB[them * 6 + 4] || !state.pieceBB[side * 6 + 5]) continue;
+        int ksq = kingSquare(state, side);
+        Bitboard zone = kingAttacksBB[ksq] | squareBB(ksq);
+        int units = popCount(zone & info.doubleAttacks[them]);
+        for (int type = 0; type < 6; type++) units += KING_ATTACK_WEIGHT[type] * popCount(zone & info.byType[them][type]);
+        mg -= sign * std::min(units * units / KING_SAFETY_DIVISOR, KING_SAFETY_MAX);
+    }
+    return (mg * phase + eg * (TOTAL_PHASE - phase)) / TOTAL_PHASE;
+}
+
+// Full evaluation, or the material and piece-square score alone when it is more than
+// LAZY_EVAL_MARGIN outside [alpha, beta] ('exact' false: only a bound on that side)
+static int evaluate(const BoardState& state, int alpha, int beta, const AttackInfo* info, bool& exact) {
+    exact = true;
+    // Known endgames and dead draws come straight from the material table
+    const MaterialEntry& material = probeMaterialTable(state);
+    if (material.drawn) return DRAW_SCORE;
+    BitbaseResult known = probeBitbase(state);
+    if (known == BITBASE_DRAW) return DRAW_SCORE;
+    if (material.evaluate) return material.evaluate(state, material.strongSide);
+    if (known != BITBASE_UNKNOWN) return evaluateKnownWin(state, (known == BITBASE_WIN) == state.whiteToMove ? 0 : 1);
+
+    int score;
+    if (nnueEnabled) {
+        score = nnueEvaluate(state);
+    } else {
+        // Material and piece-square scores are kept up to date by apply_raw_move_to_board;
+        // blend the middlegame and endgame scores by game phase
+        int phase = std::min(state.phase, TOTAL_PHASE);
+        score = (state.psqMg * phase + state.psqEg * (TOTAL_PHASE - phase)) / TOTAL_PHASE;
+        score += material.imbalance;
+
+        // The pawn and attack terms are bounded by LAZY_EVAL_MARGIN, so they cannot bring the
+        // score back into the window (skipped while scaling applies, as it could move the
+        // score across the window edge)
+        bool unscaled = material.scale[0] == SCALE_FACTOR_NORMAL && material.scale[1] == SCALE_FACTOR_NORMAL && !material.scaleFn;
+        if (unscaled && (score + LAZY_EVAL_MARGIN <= alpha || score - LAZY_EVAL_MARGIN >= beta)) {
+            exact = false;
+            lazyEvalExits.fetch_add(1, std::memory_order_relaxed);
+            return score;
+        }
+
+        // Add pawn structure evaluation
+        score += std::max(-PAWN_STRUCTURE_MAX, std::min(evaluatePawnStructure(state), PAWN_STRUCTURE_MAX));
+
+        // Mobility and king safety from the node's attack information
+        AttackInfo localInfo;
+        if (!info) {
+            computeAttackInfo(state, localInfo);
+            info = &localInfo;
+        }
+        score += evaluateAttacks(state, *info, phase);
+    }
+
+    // Scale drawish endings towards zero
+    int strongSide = (score > 0) ? 0 : 1;
+    int scale = material.scale[strongSide];
+    if (material.scaleFn) scale = std::min(scale, material.scaleFn(state, strongSide));
+    return score * scale / SCALE_FACTOR_NORMAL;
+}
+
+int evaluateBoard(const BoardState& state, int alpha, int beta, const AttackInfo* info) {
+    bool exact;
+    return evaluate(state, alpha, beta, info, exact);
+}
 
-    // Add pawn structure evaluation
-    score += evaluatePawnStructure(state);
+// Evaluation cache: (key & 0xFFFFFFFF00000000) | (uint32_t)score per entry
+static std::atomic<uint64_t> evalCache[EVAL_CACHE_SIZE];
+static std::atomic<uint64_t> evalCacheProbes(0);
+static std::atomic<uint64_t> evalCacheHits(0);
 
+int cachedEvaluateBoard(const BoardState& state, int alpha, int beta, const AttackInfo* info, bool* exact) {
+    ProfileScope profileScope(PROFILE_EVAL);
+    std::atomic<uint64_t>& slot = evalCache[state.hashKey & (EVAL_CACHE_SIZE - 1)];
+    uint64_t word = slot.load(std::memory_order_relaxed);
+    evalCacheProbes.fetch_add(1, std::memory_order_relaxed);
+    if (((word ^ state.hashKey) >> 32) == 0) {
+        evalCacheHits.fetch_add(1, std::memory_order_relaxed);
+        if (exact) *exact = true;
+        return (int32_t)(uint32_t)word;
+    }
+    bool isExact;
+    int score = evaluate(state, alpha, beta, info, isExact);
+    if (exact) *exact = isExact;
+    // Lazy scores are only bounds for this window: keep them out of the cache
+    if (isExact) slot.store((state.hashKey & 0xFFFFFFFF00000000ULL) | (uint32_t)score, std::memory_order_relaxed);
     return score;
 }
+
+void clearEvalCache() {
+    for (size_t i = 0; i < EVAL_CACHE_SIZE; ++i) evalCache[i].store(0, std::memory_order_relaxed);
+}
+
+EvalCacheStats getEvalCacheStats() {
+    EvalCacheStats stats;
+    stats.probes = evalCacheProbes.load(std::memory_order_relaxed);
+    stats.hits = evalCacheHits.load(std::memory_order_relaxed);
+    stats.lazyExits = lazyEvalExits.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void resetEvalCacheStats() {
+    evalCacheProbes.store(0, std::memory_order_relaxed);
+    evalCacheHits.store(0, std::memory_order_relaxed);
+    lazyEvalExits.store(0, std::memory_order_relaxed);
+}
@@ -2,8 +2,57 @@
 #define EVALUATION_H
 
 #include "types.h"
+#include <cstdint>
+#include <limits>
+
+struct AttackInfo;
+
+// Mobility: centipawns per safe square beyond MOBILITY_BASELINE, by piece type (N, B, R, Q)
+const int MOBILITY_MG[6] = {0, 4, 5, 2, 1, 0};
+const int MOBILITY_EG[6] = {0, 4, 5, 4, 2, 0};
+const int MOBILITY_BASELINE[6] = {0, 4, 6, 7, 13, 0};
+
+// King safety: attack units per king-zone square attacked, by attacker type, plus one per
+// square attacked twice; the middlegame penalty is units^2 / KING_SAFETY_DIVISOR
+const int KING_ATTACK_WEIGHT[6] = {1, 2, 2, 3, 5, 0};
+const int KING_SAFETY_DIVISOR = 4;
+const int KING_SAFETY_MAX = 500;
+
+// Lazy evaluation: the pawn structure and mobility terms are clamped to these bounds, so
+// together with king safety the skipped terms move the score by at most LAZY_EVAL_MARGIN
+const int PAWN_STRUCTURE_MAX = 300;
+const int MOBILITY_MAX = 150;
+const int LAZY_EVAL_MARGIN = PAWN_STRUCTURE_MAX + MOBILITY_MAX + KING_SAFETY_MAX;
 
 // Evaluate the board position from white's perspective
-int evaluateBoard(const BoardState& state);
+// (the NNUE network when enabled, otherwise the hand-crafted evaluation).
+// With a window [alpha, beta] the hand-crafted evaluation is lazy: if material and
+// piece-square scores are more than LAZY_EVAL_MARGIN outside it, the pawn, mobility and
+// king safety terms are skipped and that score is returned, which is then only a bound
+// on the same side. 'info' passes attack information the caller already computed.
+int evaluateBoard(const BoardState& state, int alpha = std::numeric_limits<int>::min(),
+                  int beta = std::numeric_limits<int>::max(), const AttackInfo* info = nullptr);
+
+// Switch between the NNUE network and the hand-crafted evaluation (clears the eval cache)
+void setUseNnue(bool enable);
+bool usingNnue();
+
+// Evaluation cache
+// Static evals by Zobrist key. An entry is one 64-bit word holding the upper half of the
+// key and the score, so a lookup is a single load and concurrent writers cannot tear it.
+// Lazy scores are returned but not cached; 'exact', if given, is set to false for them.
+int cachedEvaluateBoard(const BoardState& state, int alpha = std::numeric_limits<int>::min(),
+                        int beta = std::numeric_limits<int>::max(), const AttackInfo* info = nullptr,
+                        bool* exact = nullptr);
+void clearEvalCache();
+
+// Probe / hit counters of the evaluation cache (and lazy exits) since the last reset
+struct EvalCacheStats {
+    uint64_t probes;
+    uint64_t hits;
+    uint64_t lazyExits;
+};
+EvalCacheStats getEvalCacheStats();
+void resetEvalCacheStats();
 
 #endif // EVALUATION_H
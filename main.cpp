@@ -1,15 +1,109 @@
 #include "uci.h"
+#include "bitbase.h"
+#include "bench.h"
+#include "profile.h"
+#include "makebook.h"
+#include "match.h"
 #include <iostream>
 #include <string>
 #include <sstream>
 #include <chrono>
+#include <cstdlib>
+
+int main(int argc, char* argv[]) {
+    // Offline tools: chess_engine makebitbase <file>, chess_engine makebook ..., chess_engine match ...
+    if (argc >= 2 && std::string(argv[1]) == "makebitbase") {
+        if (argc < 3) {
+            std::cerr << "Usage: " << argv[0] << " makebitbase <file>" << std::endl;
+            return 1;
+        }
+        return generateBitbaseFile(argv[2]) ? 0 : 1;
+    }
+
+    // chess_engine makebook --pgn <file> [--pgn <file>...] [--depth N] [--min-games N] [--threads N] --out <file>
+    if (argc >= 2 && std::string(argv[1]) == "makebook") {
+        MakeBookOptions options;
+        bool valid = true;
+        for (int i = 2; i < argc && valid; ++i) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) valid = false;
+            else if (arg == "--pgn") options.pgnFiles.push_back(argv[++i]);
+            else if (arg == "--out") options.outputFile = argv[++i];
+            else if (arg == "--depth") valid = (options.depth = std::atoi(argv[++i])) > 0;
+            else if (arg == "--min-games") valid = (options.minGames = std::atoi(argv[++i])) > 0;
+            else if (arg == "--threads") valid = (options.threads = std::atoi(argv[++i])) > 0;
+            else valid = false;
+        }
+        if (!valid || options.pgnFiles.empty() || options.outputFile.empty()) {
+            std::cerr << "Usage: " << argv[0] << " makebook --pgn <file> [--pgn <file>...] [--depth plies] "
+                      << "[--min-games N] [--threads N] --out <book.bin>" << std::endl;
+            return 1;
+        }
+        return makeBook(options) ? 0 : 1;
+    }
+
+    // chess_engine match --engine <new> --engine <base> [options], see match.h
+    if (argc >= 2 && std::string(argv[1]) == "match") {
+        MatchOptions options;
+        bool valid = true;
+        for (int i = 2; i < argc && valid; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--sprt") {
+                valid = i + 2 < argc;
+                if (valid) { options.sprt = true; options.elo0 = std::atof(argv[i + 1]); options.elo1 = std::atof(argv[i + 2]); i += 2; }
+                valid = valid && options.elo1 > options.elo0;
+            }
+            else if (i + 1 >= argc) valid = false;
+            else if (arg == "--engine") options.engines.push_back(argv[++i]);
+            else if (arg == "--openings") options.openingsFile = argv[++i];
+            else if (arg == "--games") valid = (options.games = std::atoi(argv[++i])) > 0;
+            else if (arg == "--concurrency") valid = (options.concurrency = std::atoi(argv[++i])) > 0;
+            else if (arg == "--nodes") valid = (options.nodes = std::atoll(argv[++i])) > 0;
+            else if (arg == "--depth") valid = (options.depth = std::atoi(argv[++i])) > 0;
+            else if (arg == "--movetime") valid = (options.movetimeMs = std::atoll(argv[++i])) > 0;
+            else if (arg == "--hash") valid = (options.hashMB = std::atoi(argv[++i])) > 0;
+            else if (arg == "--alpha") valid = (options.alpha = std::atof(argv[++i])) > 0 && options.alpha < 1;
+            else if (arg == "--beta") valid = (options.beta = std::atof(argv[++i])) > 0 && options.beta < 1;
+            else valid = false;
+        }
+        if (!valid || options.engines.size() != 2) {
+            std::cerr << "Usage: " << argv[0] << " match --engine <new> --engine <base> [--openings file.epd] [--games N] "
+                      << "[--concurrency N] [--nodes N | --depth N | --movetime ms] [--hash MB] "
+                      << "[--sprt elo0 elo1] [--alpha a] [--beta b]" << std::endl;
+            return 1;
+        }
+        return runMatch(options) ? 0 : 1;
+    }
 
-int main() {
     // Enable unbuffered output for UCI protocol compatibility
     std::cout.setf(std::ios::unitbuf);
     std::cerr.setf(std::ios::unitbuf);
 
     global_rng.seed(std::chrono::steady_clock::now().time_since_epoch().count());
+    initKPKBitbase();
+
+    // Benchmark: chess_engine bench [depth] [--check-alloc] [--profile]
+    if (argc >= 2 && std::string(argv[1]) == "bench") {
+        int depth = BENCH_DEFAULT_DEPTH;
+        bool checkAllocations = false;
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--check-alloc") checkAllocations = true;
+            else if (arg == "--profile") { profilingEnabled = true; startProfiler(); }
+            else if (std::atoi(arg.c_str()) > 0) depth = std::atoi(arg.c_str());
+            else {
+                std::cerr << "Usage: " << argv[0] << " bench [depth] [--check-alloc] [--profile]" << std::endl;
+                return 1;
+            }
+        }
+        return runBench(depth, checkAllocations) ? 0 : 1;
+    }
+
+    // Search phase profiling after every go: chess_engine --profile
+    if (argc >= 2 && std::string(argv[1]) == "--profile") {
+        profilingEnabled = true;
+        startProfiler();
+    }
 
     std::string line;
     while (std::getline(std::cin, line)) {
@@ -20,6 +114,9 @@ int main() {
         if (command == "uci") { handleUci(); }
         else if (command == "isready") { handleIsReady(); }
         else if (command == "ucinewgame") { handleUciNewGame(); }
+        else if (command == "setoption") { handleSetOption(iss); }
+        else if (command == "savehash") { handleSaveHash(iss); }
+        else if (command == "loadhash") { handleLoadHash(iss); }
         else if (command == "position") { handlePosition(iss); }
         else if (command == "go") { handleGo(iss); }
         else if (command == "quit") { break; }
@@ -0,0 +1,366 @@
+#include "makebook.h"
+#include "polyglot.h"
+#include "movegen.h"
+#include "board.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+// One game as read from the PGN file
+struct PgnGame {
+    std::string fen;      // FEN tag, empty for the standard start position
+    std::string result;   // Result tag: "1-0", "0-1", "1/2-1/2" or "*"
+    std::string movetext;
+};
+
+struct BookMoveKey {
+    uint64_t key;
+    uint16_t move;
+    bool operator==(const BookMoveKey& other) const { return key == other.key && move == other.move; }
+};
+
+struct BookMoveKeyHash {
+    size_t operator()(const BookMoveKey& k) const { return (size_t)(k.key ^ (k.move * 0x9E3779B97F4A7C15ULL)); }
+};
+
+// Games with this move from this position, by result for the side that played it
+struct BookMoveStats {
+    uint32_t games = 0, wins = 0, draws = 0, losses = 0;
+};
+
+struct BookShard {
+    std::mutex lock;
+    std::unordered_map<BookMoveKey, BookMoveStats, BookMoveKeyHash> moves;
+};
+
+// Work shared by the reader and the workers
+struct BookBuild {
+    int depth;
+    BookShard shards[MAKEBOOK_SHARDS];
+    std::mutex queueLock;
+    std::condition_variable queueChanged;
+    std::deque<std::vector<PgnGame>> queue;
+    size_t maxQueued = 0;
+    bool inputDone = false;
+    std::atomic<uint64_t> gamesReplayed{0};
+    std::atomic<uint64_t> gamesWithErrors{0};
+};
+
+static int shardOf(uint64_t key) { return (int)(key >> 58) & (MAKEBOOK_SHARDS - 1); }
+
+// Drop comments, variations, NAGs and move numbers: what is left are SAN moves and the result
+static std::vector<std::string> movetextTokens(const std::string& movetext) {
+    std::vector<std::string> tokens;
+    std::string token;
+    int variationDepth = 0;
+    auto flush = [&]() {
+        if (!token.empty() && variationDepth == 0 && token[0] != '$') {
+            // Move numbers ("12." or "12...") may be glued to the move: "12.e4"
+            size_t start = 0;
+            while (start < token.size() && (isdigit((unsigned char)token[start]) || token[start] == '.')) start++;
+            bool isResult = token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+            if (isResult) tokens.push_back(token);
+            else if (start < token.size()) tokens.push_back(token.substr(start));
+        }
+        token.clear();
+    };
+    for (size_t i = 0; i < movetext.size(); ++i) {
+        char c = movetext[i];
+        if (c == '{') {
+            flush();
+            size_t end = movetext.find('}', i);
+            i = end == std::string::npos ? movetext.size() : end;
+        } else if (c == ';') {
+            flush();
+            size_t end = movetext.find('\n', i);
+            i = end == std::string::npos ? movetext.size() : end;
+        } else if (c == '(') {
+            flush();
+            variationDepth++;
+        } else if (c == ')') {
+            flush();
+            if (variationDepth > 0) variationDepth--;
+        } else if (isspace((unsigned char)c)) {
+            flush();
+        } else {
+            token += c;
+        }
+    }
+    flush();
+    return tokens;
+}
+
+// Find the legal move written as 'san' (e.g. "Nbd7", "exd8=Q+", "O-O"); false if none matches
+static bool parseSan(const BoardState& state, const MoveList& legalMoves, std::string san, Move& move) {
+    while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?')) san.pop_back();
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+        bool kingSide = san.size() == 3;
+        for (const Move& m : legalMoves) {
+            if (kingSide ? m.isKingSideCastle : m.isQueenSideCastle) { move = m; return true; }
+        }
+        return false;
+    }
+
+    char piece = W_PAWN;
+    size_t pos = 0;
+    if (!san.empty() && strchr("KQRBN", san[0])) piece = san[pos++];
+
+    // Promotion: "e8=Q" or "e8Q"
+    char promotion = EMPTY;
+    size_t equals = san.find('=');
+    if (equals != std::string::npos && equals + 1 < san.size()) {
+        promotion = san[equals + 1];
+        san.erase(equals);
+    } else if (piece == W_PAWN && san.size() >= 3 && strchr("QRBN", san.back())) {
+        promotion = san.back();
+        san.pop_back();
+    }
+
+    san.erase(std::remove(san.begin() + pos, san.end(), 'x'), san.end());
+    if (san.size() < pos + 2) return false;
+    int toCol = san[san.size() - 2] - 'a', toRow = '8' - san[san.size() - 1];
+    if (toCol < 0 || toCol > 7 || toRow < 0 || toRow > 7) return false;
+
+    // Disambiguation: from-file, from-rank or both
+    int fromCol = -1, fromRow = -1;
+    for (size_t i = pos; i + 2 < san.size(); ++i) {
+        if (san[i] >= 'a' && san[i] <= 'h') fromCol = san[i] - 'a';
+        else if (san[i] >= '1' && san[i] <= '8') fromRow = '8' - san[i];
+        else return false;
+    }
+
+    for (const Move& m : legalMoves) {
+        if (m.toRow != toRow || m.toCol != toCol || m.isKingSideCastle || m.isQueenSideCastle) continue;
+        if (toupper(state.board[m.fromRow][m.fromCol]) != piece) continue;
+        if ((fromCol != -1 && m.fromCol != fromCol) || (fromRow != -1 && m.fromRow != fromRow)) continue;
+        if ((m.promotionPiece == EMPTY ? EMPTY : (char)toupper(m.promotionPiece)) != promotion) continue;
+        move = m;
+        return true;
+    }
+    return false;
+}
+
+struct BookRecord {
+    BookMoveKey key;
+    int result; // 1 win, 0 draw, -1 loss for the side to move, 2 unknown
+};
+
+// Replay one game, appending a record per book ply; false if the FEN tag or a move could not be read
+static bool replayGame(const PgnGame& game, int depth, std::vector<BookRecord>& records) {
+    int whiteResult = game.result == "1-0" ? 1 : game.result == "0-1" ? -1 : game.result == "1/2-1/2" ? 0 : 2;
+    BoardState state;
+    if (!game.fen.empty()) {
+        if (!isValidFen(game.fen)) return false;
+        state.parseFen(game.fen);
+    }
+    MoveList legalMoves;
+    int ply = 0;
+    for (const std::string& token : movetextTokens(game.movetext)) {
+        if (ply >= depth || token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*") break;
+        legalMoves.clear();
+        generateLegalMoves(state, legalMoves, false);
+        Move move;
+        if (!parseSan(state, legalMoves, token, move)) return false;
+        int result = whiteResult == 2 ? 2 : state.whiteToMove ? whiteResult : -whiteResult;
+        records.push_back({{polyglotKey(state), encodePolyglotMove(move)}, result});
+        apply_raw_move_to_board(state, move);
+        ply++;
+    }
+    return true;
+}
+
+// Add a batch's records to the shards, taking each shard's lock once
+static void mergeRecords(BookBuild& build, std::vector<BookRecord>& records) {
+    std::sort(records.begin(), records.end(), [](const BookRecord& a, const BookRecord& b) {
+        return shardOf(a.key.key) < shardOf(b.key.key);
+    });
+    for (size_t i = 0; i < records.size(); ) {
+        int shard = shardOf(records[i].key.key);
+        std::lock_guard<std::mutex> guard(build.shards[shard].lock);
+        for (; i < records.size() && shardOf(records[i].key.key) == shard; ++i) {
+            BookMoveStats& stats = build.shards[shard].moves[records[i].key];
+            stats.games++;
+            if (records[i].result == 1) stats.wins++;
+            else if (records[i].result == 0) stats.draws++;
+            else if (records[i].result == -1) stats.losses++;
+        }
+    }
+    records.clear();
+}
+
+static void bookWorker(BookBuild& build) {
+    std::vector<BookRecord> records;
+    for (;;) {
+        std::vector<PgnGame> batch;
+        {
+            std::unique_lock<std::mutex> guard(build.queueLock);
+            build.queueChanged.wait(guard, [&]() { return !build.queue.empty() || build.inputDone; });
+            if (build.queue.empty()) return;
+            batch = std::move(build.queue.front());
+            build.queue.pop_front();
+        }
+        build.queueChanged.notify_all();
+        for (const PgnGame& game : batch) {
+            if (replayGame(game, build.depth, records)) build.gamesReplayed++;
+            else build.gamesWithErrors++;
+        }
+        mergeRecords(build, records);
+    }
+}
+
+static void queueBatch(BookBuild& build, std::vector<PgnGame>& batch) {
+    if (batch.empty()) return;
+    {
+        std::unique_lock<std::mutex> guard(build.queueLock);
+        build.queueChanged.wait(guard, [&]() { return build.queue.size() < build.maxQueued; });
+        build.queue.push_back(std::move(batch));
+    }
+    build.queueChanged.notify_all();
+    batch.clear();
+}
+
+// Value of a tag line such as [Result "1-0"]
+static std::string tagValue(const std::string& line) {
+    size_t open = line.find('"'), close = line.rfind('"');
+    return (open == std::string::npos || close <= open) ? "" : line.substr(open + 1, close - open - 1);
+}
+
+// Stream one PGN file into batches of games; returns the number of games read
+static uint64_t readPgnFile(BookBuild& build, std::ifstream& file, uint64_t gamesBefore) {
+    std::vector<PgnGame> batch;
+    PgnGame game;
+    uint64_t games = 0;
+    auto finishGame = [&]() {
+        if (!game.movetext.empty()) {
+            batch.push_back(std::move(game));
+            games++;
+            if ((gamesBefore + games) % MAKEBOOK_PROGRESS_GAMES == 0) {
+                std::cout << "Games read: " << gamesBefore + games << std::endl;
+            }
+            if ((int)batch.size() == MAKEBOOK_BATCH_GAMES) queueBatch(build, batch);
+        }
+        game = PgnGame();
+    };
+    std::string line;
+    bool inTags = false;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty() && line[0] == '[') {
+            // The first tag of a block starts the next game, even if the last one had no movetext
+            if (!inTags) finishGame();
+            inTags = true;
+            if (line.compare(0, 8, "[Result ") == 0) game.result = tagValue(line);
+            else if (line.compare(0, 5, "[FEN ") == 0) game.fen = tagValue(line);
+            continue;
+        }
+        inTags = false;
+        if (!line.empty() && line[0] != '%') {
+            game.movetext += line;
+            game.movetext += '\n';
+        }
+    }
+    finishGame();
+    queueBatch(build, batch);
+    return games;
+}
+
+bool makeBook(const MakeBookOptions& options) {
+    BookBuild build;
+    build.depth = options.depth;
+    int threads = options.threads > 0 ? options.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+    build.maxQueued = (size_t)threads * MAKEBOOK_QUEUED_BATCHES;
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) workers.emplace_back(bookWorker, std::ref(build));
+
+    bool ok = true;
+    uint64_t gamesRead = 0;
+    for (const std::string& path : options.pgnFiles) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open PGN file: " << path << std::endl;
+            ok = false;
+            break;
+        }
+        gamesRead += readPgnFile(build, file, gamesRead);
+    }
+    {
+        std::lock_guard<std::mutex> guard(build.queueLock);
+        build.inputDone = true;
+    }
+    build.queueChanged.notify_all();
+    for (std::thread& worker : workers) worker.join();
+    if (!ok) return false;
+
+    // Entries for moves played often enough, weighted 2 per win and 1 per draw
+    struct WeightedEntry {
+        PolyglotEntry entry;
+        uint64_t weight;
+    };
+    std::vector<WeightedEntry> weighted;
+    uint64_t positionMoves = 0;
+    for (BookShard& shard : build.shards) {
+        positionMoves += shard.moves.size();
+        for (const auto& item : shard.moves) {
+            const BookMoveStats& stats = item.second;
+            uint64_t weight = 2ULL * stats.wins + stats.draws;
+            if ((int)stats.games < options.minGames || weight == 0) continue;
+            weighted.push_back({{item.first.key, item.first.move, 0, 0}, weight});
+        }
+        shard.moves.clear();
+    }
+    std::sort(weighted.begin(), weighted.end(), [](const WeightedEntry& a, const WeightedEntry& b) {
+        return a.entry.key != b.entry.key ? a.entry.key < b.entry.key : a.weight > b.weight;
+    });
+    // Weights are 16 bits: a position whose largest count does not fit has all its moves
+    // scaled by that count, keeping every entry at least 1. Other positions are unchanged.
+    std::vector<PolyglotEntry> entries;
+    entries.reserve(weighted.size());
+    for (size_t first = 0; first < weighted.size(); ) {
+        size_t last = first;
+        while (last < weighted.size() && weighted[last].entry.key == weighted[first].entry.key) last++;
+        uint64_t maxWeight = weighted[first].weight;
+        for (size_t i = first; i < last; ++i) {
+            uint64_t weight = weighted[i].weight;
+            if (maxWeight > 0xFFFF) weight = std::max<uint64_t>(1, weight * 0xFFFF / maxWeight);
+            entries.push_back(weighted[i].entry);
+            entries.back().weight = (uint16_t)weight;
+        }
+        first = last;
+    }
+    weighted.clear();
+    weighted.shrink_to_fit();
+    std::sort(entries.begin(), entries.end(), [](const PolyglotEntry& a, const PolyglotEntry& b) {
+        return a.key != b.key ? a.key < b.key : a.weight != b.weight ? a.weight > b.weight : a.move < b.move;
+    });
+
+    std::ofstream out(options.outputFile, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not write book file: " << options.outputFile << std::endl;
+        return false;
+    }
+    unsigned char bytes[POLYGLOT_ENTRY_BYTES];
+    for (const PolyglotEntry& entry : entries) {
+        writePolyglotEntry(entry, bytes);
+        out.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+    }
+    if (!out) {
+        std::cerr << "Error: Could not write book file: " << options.outputFile << std::endl;
+        return false;
+    }
+
+    std::cout << "Games read: " << gamesRead << " (" << build.gamesWithErrors.load()
+              << " with an invalid FEN tag or an unreadable move)" << std::endl;
+    std::cout << "Position moves seen: " << positionMoves << std::endl;
+    std::cout << "Book entries written: " << entries.size() << " to " << options.outputFile << std::endl;
+    return true;
+}
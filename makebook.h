@@ -0,0 +1,35 @@
+#ifndef MAKEBOOK_H
+#define MAKEBOOK_H
+
+#include <string>
+#include <vector>
+
+// Polyglot book builder:
+//   chess_engine makebook --pgn games.pgn [--pgn more.pgn] [--depth 20] [--min-games 5]
+//                         [--threads N] --out book.bin
+// PGN files are streamed in batches of games to a pool of worker threads. Each worker
+// replays the SAN moves through the legal move generator and counts, for every
+// position up to 'depth' plies and every move played from it, the games and their
+// results for the side to move. Counts go into hash maps sharded by position, each
+// behind its own mutex. Moves seen in at least 'minGames' games are written as a
+// sorted Polyglot book (see polyglot.h) weighted 2 per win and 1 per draw.
+
+const int MAKEBOOK_DEFAULT_DEPTH = 20;      // Plies
+const int MAKEBOOK_DEFAULT_MIN_GAMES = 5;
+const int MAKEBOOK_BATCH_GAMES = 256;       // Games handed to a worker at once
+const int MAKEBOOK_QUEUED_BATCHES = 4;      // Batches waiting per worker before the reader blocks
+const int MAKEBOOK_SHARDS = 64;             // Power of two
+const int MAKEBOOK_PROGRESS_GAMES = 100000; // Progress line interval
+
+struct MakeBookOptions {
+    std::vector<std::string> pgnFiles;
+    std::string outputFile;
+    int depth = MAKEBOOK_DEFAULT_DEPTH;
+    int minGames = MAKEBOOK_DEFAULT_MIN_GAMES;
+    int threads = 0; // 0: one per hardware thread
+};
+
+// Build the book (progress on stdout). Errors are reported on stderr and return false.
+bool makeBook(const MakeBookOptions& options);
+
+#endif // MAKEBOOK_H
@@ -0,0 +1,325 @@
+#include "match.h"
+#include "uci.h"
+#include "movegen.h"
+#include "board.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <poll.h>
+#include <signal.h>
+#include <sstream>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+static const char START_FEN[] = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+static const int ENGINE_START_TIMEOUT_MS = 10000;
+
+// A child engine process talking UCI over two pipes
+struct EngineProcess {
+    std::string path;
+    std::string name;   // From "id name", the path until the engine reports it
+    pid_t pid = -1;
+    int input = -1;     // Engine's stdin
+    int output = -1;    // Engine's stdout
+    std::string buffer; // Output read but not yet returned as lines
+};
+
+static bool sendLine(EngineProcess& engine, const std::string& line) {
+    std::string text = line + "\n";
+    for (size_t written = 0; written < text.size(); ) {
+        ssize_t n = write(engine.input, text.data() + written, text.size() - written);
+        if (n <= 0) return false;
+        written += (size_t)n;
+    }
+    return true;
+}
+
+// Next output line; false on end of file or when 'timeoutMs' passes first
+static bool readLine(EngineProcess& engine, std::string& line, long long timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    for (;;) {
+        size_t newline = engine.buffer.find('\n');
+        if (newline != std::string::npos) {
+            line = engine.buffer.substr(0, newline);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            engine.buffer.erase(0, newline + 1);
+            return true;
+        }
+        long long remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) return false;
+        pollfd fd = {engine.output, POLLIN, 0};
+        if (poll(&fd, 1, (int)std::min<long long>(remaining, 1000)) < 0 && errno != EINTR) return false;
+        if (fd.revents & (POLLIN | POLLHUP)) {
+            char chunk[4096];
+            ssize_t n = read(engine.output, chunk, sizeof(chunk));
+            if (n <= 0) return false;
+            engine.buffer.append(chunk, (size_t)n);
+        }
+    }
+}
+
+// Read until a line starting with 'prefix'
+static bool waitFor(EngineProcess& engine, const std::string& prefix, long long timeoutMs, std::string& line) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    for (;;) {
+        long long remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (!readLine(engine, line, std::max(0LL, remaining))) return false;
+        if (line.compare(0, prefix.size(), prefix) == 0) return true;
+        if (line.compare(0, 8, "id name ") == 0) engine.name = line.substr(8);
+    }
+}
+
+static void stopEngine(EngineProcess& engine) {
+    if (engine.pid <= 0) return;
+    sendLine(engine, "quit");
+    close(engine.input);
+    close(engine.output);
+    // Give it a moment to exit cleanly
+    for (int i = 0; i < 100 && waitpid(engine.pid, nullptr, WNOHANG) == 0; ++i) usleep(10000);
+    if (waitpid(engine.pid, nullptr, WNOHANG) == 0) {
+        kill(engine.pid, SIGKILL);
+        waitpid(engine.pid, nullptr, 0);
+    }
+    engine.pid = -1;
+    engine.buffer.clear();
+}
+
+static bool startEngine(EngineProcess& engine, const MatchOptions& options) {
+    int toEngine[2], fromEngine[2];
+    // Close-on-exec: engines started by other workers must not inherit these pipes
+    if (pipe2(toEngine, O_CLOEXEC) != 0) return false;
+    if (pipe2(fromEngine, O_CLOEXEC) != 0) {
+        close(toEngine[0]);
+        close(toEngine[1]);
+        return false;
+    }
+    const char* path = engine.path.c_str();
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Child: only async-signal-safe calls until exec
+        dup2(toEngine[0], STDIN_FILENO);
+        dup2(fromEngine[1], STDOUT_FILENO);
+        int devNull = open("/dev/null", O_WRONLY);
+        if (devNull >= 0) dup2(devNull, STDERR_FILENO);
+        execl(path, path, (char*)nullptr);
+        _exit(127);
+    }
+    close(toEngine[0]);
+    close(fromEngine[1]);
+    if (pid < 0) {
+        close(toEngine[1]);
+        close(fromEngine[0]);
+        return false;
+    }
+    engine.pid = pid;
+    engine.input = toEngine[1];
+    engine.output = fromEngine[0];
+    engine.buffer.clear();
+    if (engine.name.empty()) engine.name = engine.path;
+
+    std::string line;
+    bool ok = sendLine(engine, "uci") && waitFor(engine, "uciok", ENGINE_START_TIMEOUT_MS, line) &&
+              sendLine(engine, "setoption name Hash value " + std::to_string(options.hashMB)) &&
+              sendLine(engine, "setoption name BookFile value <empty>") &&
+              sendLine(engine, "isready") && waitFor(engine, "readyok", ENGINE_START_TIMEOUT_MS, line);
+    if (!ok) stopEngine(engine);
+    return ok;
+}
+
+// EPD positions (first four fields) as FENs; the start position if 'path' is empty
+static bool loadOpenings(const std::string& path, std::vector<std::string>& openings) {
+    if (path.empty()) {
+        openings.assign(1, START_FEN);
+        return true;
+    }
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open openings file: " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string board, side, castling, enPassant;
+        if (!(fields >> board >> side >> castling >> enPassant) || board[0] == '#') continue;
+        openings.push_back(board + " " + side + " " + castling + " " + enPassant + " 0 1");
+    }
+    if (openings.empty()) {
+        std::cerr << "Error: No positions in openings file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Play one game; returns the result ("1-0 {White mates}", ...). A side that fails is marked in 'failed'.
+static std::string playGame(EngineProcess* players[2], const std::string& fen, const MatchOptions& options, bool failed[2]) {
+    std::string goCommand = options.movetimeMs > 0 ? "go movetime " + std::to_string(options.movetimeMs)
+                          : options.depth > 0 ? "go depth " + std::to_string(options.depth)
+                          : "go nodes " + std::to_string(options.nodes > 0 ? options.nodes : MATCH_DEFAULT_NODES);
+    long long replyTimeoutMs = options.movetimeMs + MATCH_MOVE_TIMEOUT_MS;
+    std::string line;
+    for (int side = 0; side < 2; ++side) {
+        if (!sendLine(*players[side], "ucinewgame") || !sendLine(*players[side], "isready") ||
+            !waitFor(*players[side], "readyok", ENGINE_START_TIMEOUT_MS, line)) {
+            failed[side] = true;
+            return side == 0 ? "0-1 {White disconnects}" : "1-0 {Black disconnects}";
+        }
+    }
+
+    BoardState state;
+    state.parseFen(fen);
+    std::vector<uint64_t> history(1, state.hashKey);
+    std::string positionCommand = "position fen " + fen + " moves";
+    for (int ply = 0; ply < MATCH_MAX_PLIES; ++ply) {
+        std::string status = gameEndStatus(state, history);
+        if (!status.empty()) return status;
+
+        int side = state.whiteToMove ? 0 : 1;
+        std::string loss = side == 0 ? "0-1 {White " : "1-0 {Black ";
+        EngineProcess& engine = *players[side];
+        if (!sendLine(engine, positionCommand) || !sendLine(engine, goCommand) ||
+            !waitFor(engine, "bestmove", replyTimeoutMs, line)) {
+            failed[side] = true;
+            return loss + "disconnects or does not reply}";
+        }
+        std::istringstream reply(line);
+        std::string token, uciMove;
+        reply >> token >> uciMove;
+
+        MoveList legalMoves;
+        generateLegalMoves(state, legalMoves, false);
+        auto played = std::find_if(legalMoves.begin(), legalMoves.end(), [&](const Move& m) { return m.toUci() == uciMove; });
+        if (played == legalMoves.end()) return loss + "makes an illegal move: " + uciMove + "}";
+
+        // As master_apply_move, on this game's state
+        bool resetsClock = toupper(state.board[played->fromRow][played->fromCol]) == W_PAWN ||
+                           state.board[played->toRow][played->toCol] != EMPTY || played->isEnPassantCapture;
+        apply_raw_move_to_board(state, *played);
+        state.halfmoveClock = resetsClock ? 0 : state.halfmoveClock + 1;
+        if (state.whiteToMove) state.fullmoveNumber++;
+        history.push_back(state.hashKey);
+        positionCommand += " " + uciMove;
+    }
+    return "1/2-1/2 {Adjudicated after " + std::to_string(MATCH_MAX_PLIES) + " plies}";
+}
+
+static double scoreToElo(double score) {
+    score = std::min(std::max(score, 1e-6), 1 - 1e-6);
+    return 400.0 * std::log10(score / (1.0 - score));
+}
+
+static double eloToScore(double elo) { return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0)); }
+
+// Shared by the workers
+struct MatchProgress {
+    std::mutex lock;
+    std::atomic<int> nextGame{0};
+    std::atomic<bool> stop{false};
+    int played = 0, wins = 0, losses = 0, draws = 0; // First engine's view
+    double lowerBound = 0, upperBound = 0;
+};
+
+// Score, Elo and LLR lines after a finished game; sets 'stop' when the SPRT decides
+static void reportProgress(MatchProgress& progress, const MatchOptions& options, const std::string& firstName, const std::string& secondName) {
+    int n = progress.wins + progress.losses + progress.draws;
+    double score = (progress.wins + 0.5 * progress.draws) / n;
+    double variance = (progress.wins * std::pow(1 - score, 2) + progress.draws * std::pow(0.5 - score, 2) +
+                       progress.losses * std::pow(score, 2)) / n;
+    double margin = 1.96 * std::sqrt(variance / n);
+    std::cout << "Score of " << firstName << " vs " << secondName << ": " << progress.wins << " - " << progress.losses
+              << " - " << progress.draws << " [" << std::fixed << std::setprecision(3) << score << "] " << n << std::endl;
+    std::cout << "Elo difference: " << std::setprecision(1) << scoreToElo(score) << " [" << scoreToElo(score - margin)
+              << ", " << scoreToElo(score + margin) << "]" << std::endl;
+    if (!options.sprt) return;
+
+    // Normal approximation of the generalised SPRT log-likelihood ratio
+    double s0 = eloToScore(options.elo0), s1 = eloToScore(options.elo1);
+    double llr = variance > 0 ? n * (s1 - s0) * (2 * score - s0 - s1) / (2 * variance) : 0;
+    std::cout << "SPRT: llr " << std::setprecision(2) << llr << " [" << progress.lowerBound << ", " << progress.upperBound
+              << "] (elo0 " << options.elo0 << ", elo1 " << options.elo1 << ")" << std::endl;
+    if (llr >= progress.upperBound || llr <= progress.lowerBound) {
+        if (!progress.stop.exchange(true)) {
+            std::cout << "SPRT: " << (llr >= progress.upperBound ? "H1 accepted" : "H0 accepted") << std::endl;
+        }
+    }
+}
+
+static void matchWorker(MatchProgress& progress, const MatchOptions& options, const std::vector<std::string>& openings) {
+    EngineProcess engines[2];
+    engines[0].path = options.engines[0];
+    engines[1].path = options.engines[1];
+    for (;;) {
+        int game = progress.nextGame.fetch_add(1);
+        if (game >= options.games || progress.stop.load()) break;
+        // (Re)start engines that are not running
+        bool started = true;
+        for (EngineProcess& engine : engines) {
+            if (engine.pid <= 0 && !startEngine(engine, options)) {
+                std::lock_guard<std::mutex> guard(progress.lock);
+                std::cerr << "Error: Could not start engine: " << engine.path << std::endl;
+                started = false;
+            }
+        }
+        if (!started) { progress.stop.store(true); break; }
+        // The same engine on both sides (e.g. two builds): tell them apart by path
+        if (engines[0].name == engines[1].name) {
+            engines[0].name = engines[0].path;
+            engines[1].name = engines[1].path;
+        }
+
+        // Each opening twice, the first engine with white in even games
+        const std::string& fen = openings[(game / 2) % openings.size()];
+        bool firstIsWhite = game % 2 == 0;
+        EngineProcess* players[2] = {firstIsWhite ? &engines[0] : &engines[1], firstIsWhite ? &engines[1] : &engines[0]};
+        bool failed[2] = {false, false};
+        std::string result = playGame(players, fen, options, failed);
+        for (int side = 0; side < 2; ++side) {
+            if (failed[side]) stopEngine(*players[side]);
+        }
+
+        int whiteScore = result.compare(0, 3, "1-0") == 0 ? 1 : result.compare(0, 3, "0-1") == 0 ? -1 : 0;
+        int firstScore = firstIsWhite ? whiteScore : -whiteScore;
+        std::lock_guard<std::mutex> guard(progress.lock);
+        if (firstScore > 0) progress.wins++;
+        else if (firstScore < 0) progress.losses++;
+        else progress.draws++;
+        progress.played++;
+        std::cout << "Game " << game + 1 << "/" << options.games << ": " << players[0]->name << " vs " << players[1]->name
+                  << ": " << result << std::endl;
+        reportProgress(progress, options, engines[0].name, engines[1].name);
+    }
+    stopEngine(engines[0]);
+    stopEngine(engines[1]);
+}
+
+bool runMatch(const MatchOptions& options) {
+    std::vector<std::string> openings;
+    if (!loadOpenings(options.openingsFile, openings)) return false;
+    // A crashed engine must not kill the runner when we write to its pipe
+    signal(SIGPIPE, SIG_IGN);
+
+    MatchProgress progress;
+    progress.lowerBound = std::log(options.beta / (1 - options.alpha));
+    progress.upperBound = std::log((1 - options.beta) / options.alpha);
+    int workers = options.concurrency > 0 ? options.concurrency : (int)std::max(1u, std::thread::hardware_concurrency());
+    workers = std::min(workers, options.games);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < workers; ++i) threads.emplace_back(matchWorker, std::ref(progress), std::cref(options), std::cref(openings));
+    for (std::thread& thread : threads) thread.join();
+
+    if (progress.played == 0) {
+        std::cerr << "Error: No games were played" << std::endl;
+        return false;
+    }
+    std::cout << "Finished: " << progress.played << " games" << std::endl;
+    return true;
+}
@@ -0,0 +1,45 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include <string>
+#include <vector>
+
+// Engine-vs-engine match runner:
+//   chess_engine match --engine <new> --engine <base> [--openings file.epd] [--games N]
+//                      [--concurrency N] [--nodes N | --depth N | --movetime ms] [--hash MB]
+//                      [--sprt elo0 elo1] [--alpha a] [--beta b]
+// Each worker thread starts both engines as child processes talking UCI over pipes and
+// plays games from a shared queue. Every opening is played twice with colours swapped,
+// and engines' own opening books are turned off. Games end by the rules (gameEndStatus in
+// uci.h) or as a draw at MATCH_MAX_PLIES; an illegal move, a crash or no reply loses.
+//
+// Results are reported from the first engine's point of view: W-L-D, the Elo difference
+// with a 95% interval and, with --sprt, the log-likelihood ratio of H1 (elo1) against H0
+// (elo0). The match stops once the LLR leaves [ln(beta / (1 - alpha)), ln((1 - beta) / alpha)].
+
+const int MATCH_DEFAULT_GAMES = 100;
+const int MATCH_DEFAULT_NODES = 20000;  // Used when no limit is given
+const int MATCH_DEFAULT_HASH_MB = 16;
+const int MATCH_MAX_PLIES = 400;         // Adjudicated as a draw after this many plies
+const int MATCH_MOVE_TIMEOUT_MS = 60000; // No bestmove after the move's limit plus this: loss
+const double MATCH_DEFAULT_SPRT_ALPHA = 0.05;
+const double MATCH_DEFAULT_SPRT_BETA = 0.05;
+
+struct MatchOptions {
+    std::vector<std::string> engines;  // Exactly two
+    std::string openingsFile;          // EPD, one position per line; start position if empty
+    int games = MATCH_DEFAULT_GAMES;
+    int concurrency = 0;               // 0: one game per hardware thread
+    long long nodes = 0;
+    int depth = 0;
+    long long movetimeMs = 0;
+    int hashMB = MATCH_DEFAULT_HASH_MB;
+    bool sprt = false;
+    double elo0 = 0, elo1 = 5;
+    double alpha = MATCH_DEFAULT_SPRT_ALPHA, beta = MATCH_DEFAULT_SPRT_BETA;
+};
+
+// Play the match (progress on stdout). Errors are reported on stderr and return false.
+bool runMatch(const MatchOptions& options);
+
+#endif // MATCH_H
@@ -0,0 +1,94 @@
+#include "material.h"
+#include "board.h"
+#include "constants.h"
+#include <cstring>
+
+// Material hash table
+static MaterialEntry materialTable[MATERIAL_HASH_SIZE];
+
+void clearMaterialTable() {
+    std::memset(materialTable, 0, sizeof(materialTable));
+}
+
+// Material keys differ mostly in their low (pawn) nibbles, so mix before indexing
+static size_t materialIndex(uint64_t key) {
+    return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (MATERIAL_HASH_SIZE - 1);
+}
+
+static void computeMaterialEntry(uint64_t key, MaterialEntry& entry) {
+    entry.key = key;
+    entry.valid = true;
+    entry.imbalance = 0;
+    entry.drawn = false;
+    entry.evaluate = nullptr;
+    entry.strongSide = 0;
+    entry.scaleFn = nullptr;
+    entry.scale[0] = entry.scale[1] = SCALE_FACTOR_NORMAL;
+
+    int count[2][6];
+    int nonPawn[2], minors[2], pieces[2];
+    for (int side = 0; side < 2; ++side) {
+        nonPawn[side] = 0;
+        for (int type = 0; type < 6; ++type) {
+            count[side][type] = materialCount(key, side * 6 + type);
+            if (type != 0 && type != 5) nonPawn[side] += count[side][type] * piece_values[type];
+        }
+        minors[side] = count[side][1] + count[side][2];
+        pieces[side] = minors[side] + count[side][3] + count[side][4];
+    }
+
+    // Imbalance: bishop pair; knights gain and rooks lose value as pawns are added
+    for (int side = 0; side < 2; ++side) {
+        int sign = (side == 0) ? 1 : -1;
+        int extraPawns = count[side][0] - 5;
+        if (count[side][2] >= 2) entry.imbalance += sign * BISHOP_PAIR_BONUS;
+        entry.imbalance += sign * count[side][1] * extraPawns * KNIGHT_PAWN_ADJUSTMENT;
+        entry.imbalance += sign * count[side][3] * extraPawns * ROOK_PAWN_ADJUSTMENT;
+    }
+
+    // Dead draws: no pawns and at most one minor each, or two knights against a bare king
+    if (count[0][0] == 0 && count[1][0] == 0) {
+        bool minorOnly[2];
+        for (int side = 0; side < 2; ++side) minorOnly[side] = pieces[side] == minors[side] && minors[side] <= 1;
+        if (minorOnly[0] && minorOnly[1]) { entry.drawn = true; return; }
+        for (int side = 0; side < 2; ++side) {
+            if (pieces[side] == 2 && count[side][1] == 2 && pieces[side ^ 1] == 0) { entry.drawn = true; return; }
+        }
+    }
+
+    // Specialised evaluators against a bare king
+    for (int side = 0; side < 2; ++side) {
+        int weak = side ^ 1;
+        if (pieces[weak] != 0 || count[weak][0] != 0) continue;
+        if (count[side][0] == 0 && pieces[side] == 2 && count[side][1] == 1 && count[side][2] == 1) {
+            entry.evaluate = evaluateKBNK;
+        } else if (count[side][0] == 1 && pieces[side] == 0) {
+            entry.evaluate = evaluateKPK;
+        } else if (count[side][0] == 0 && pieces[side] == count[side][2]) {
+            // Bishops only: the material key cannot tell whether they are on both colours
+            entry.evaluate = evaluateKBBK;
+        } else if (nonPawn[side] >= piece_values[3]) {
+            entry.evaluate = evaluateKXK;
+        }
+        if (entry.evaluate) { entry.strongSide = side; return; }
+    }
+
+    // A side without pawns needs more than a minor's worth of extra material to win
+    for (int side = 0; side < 2; ++side) {
+        if (count[side][0] != 0) continue;
+        if (nonPawn[side] - nonPawn[side ^ 1] <= piece_values[2]) {
+            entry.scale[side] = (nonPawn[side] < piece_values[3]) ? SCALE_FACTOR_DRAW : SCALE_FACTOR_NORMAL / 8;
+        }
+    }
+
+    // One bishop each and only pawns besides: the bishops' colours decide
+    if (pieces[0] == 1 && pieces[1] == 1 && count[0][2] == 1 && count[1][2] == 1) {
+        entry.scaleFn = scaleOppositeBishops;
+    }
+}
+
+const MaterialEntry& probeMaterialTable(const BoardState& state) {
+    MaterialEntry& entry = materialTable[materialIndex(state.materialKey)];
+    if (!entry.valid || entry.key != state.materialKey) computeMaterialEntry(state.materialKey, entry);
+    return entry;
+}
@@ -0,0 +1,32 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include "types.h"
+#include "endgame.h"
+
+// Material imbalance constants (in centipawns)
+const int BISHOP_PAIR_BONUS = 30;
+const int KNIGHT_PAWN_ADJUSTMENT = 6;   // Per knight, per own pawn above 5
+const int ROOK_PAWN_ADJUSTMENT = -12;   // Per rook, per own pawn above 5
+
+// Material hash table size (entries, power of two)
+const int MATERIAL_HASH_SIZE = 8192;
+
+// Cached data for one material configuration, keyed by BoardState::materialKey.
+// Index [0] is white, [1] black.
+struct MaterialEntry {
+    uint64_t key;
+    bool valid;
+    int imbalance;              // White's perspective
+    bool drawn;                 // Neither side can force mate
+    EndgameEvalFn evaluate;     // Replaces the normal evaluation (nullptr if none)
+    int strongSide;             // Side 'evaluate' plays for
+    EndgameScaleFn scaleFn;     // Position-dependent scale factor (nullptr if none)
+    uint8_t scale[2];           // Scale factor applied when that side is ahead
+};
+
+// Material table: returns the cached entry for the position's material, computing it on a miss
+const MaterialEntry& probeMaterialTable(const BoardState& state);
+void clearMaterialTable();
+
+#endif // MATERIAL_H
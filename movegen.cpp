@@ -2,189 +2,297 @@
 #include "board.h"
 #include "constants.h"
 #include "search.h"
+#include "attacks.h"
+#include "profile.h"
 #include <algorithm>
 #include <cctype>
 
+// Pieces of side Us (white pieces are upper case, black lower case)
+template <Color Us> static inline bool isOwnPiece(char piece) {
+    return Us == WHITE ? (piece >= 'A' && piece <= 'Z') : (piece >= 'a' && piece <= 'z');
+}
+
+// The generators are instantiated per side to move, so colour tests fold away at compile
+// time. The non-template functions below dispatch on state.whiteToMove once. Targets come
+// from the attack tables (attacks.h), so no square needs a bounds check.
+
 // Add a move to the list after validation
-void addMove(const BoardState& s, int r1, int c1, int r2, int c2, std::vector<Move>& m,
-             char promo, bool ksc, bool qsc, bool ep) {
+template <Color Us>
+static void addMove(const BoardState& s, int r1, int c1, int r2, int c2, MoveList& m,
+                    char promo = EMPTY, bool ksc = false, bool qsc = false, bool ep = false) {
     if(!isSquareOnBoard(r1,c1) || !isSquareOnBoard(r2,c2)) return;
-    char piece=getPieceAt(s,r1,c1), target=getPieceAt(s,r2,c2);
-    if(piece==EMPTY || (s.whiteToMove && isWhitePiece(target)) || (!s.whiteToMove && isBlackPiece(target))) return;
+    if(s.board[r1][c1]==EMPTY || isOwnPiece<Us>(s.board[r2][c2])) return;
     m.emplace_back(r1,c1,r2,c2,promo,ksc,qsc,ep);
 }
 
+// Add a move from 'from' to every square in 'targets'
+static inline void addMoves(int from, Bitboard targets, MoveList& moves) {
+    while (targets) {
+        int to = popLsb(targets);
+        moves.emplace_back(from / 8, from % 8, to / 8, to % 8);
+    }
+}
+
+// Squares a piece of side Us may move to: not its own pieces, and only enemy pieces for captures
+template <Color Us>
+static inline Bitboard targetSquares(const BoardState& state, bool capturesOnly) {
+    return capturesOnly ? state.occupancy[Us ^ 1] : ~state.occupancy[Us];
+}
+
 // Generate pawn moves
-void generatePawnMoves(const BoardState& state, int r, int c, std::vector<Move>& moves, bool capturesOnly) {
-    char piece = state.board[r][c];
-    int direction = (isWhitePiece(piece)) ? -1 : 1;
-    char promotionPieces[] = {state.whiteToMove ? W_QUEEN : B_QUEEN, state.whiteToMove ? W_ROOK : B_ROOK,
-                              state.whiteToMove ? W_BISHOP : B_BISHOP, state.whiteToMove ? W_KNIGHT : B_KNIGHT};
-    int promotion_rank = state.whiteToMove ? 0 : 7;
-    int start_rank = state.whiteToMove ? 6 : 1;
-    if (!capturesOnly && isSquareOnBoard(r + direction, c) && state.board[r + direction][c] == EMPTY) {
-        if (r + direction == promotion_rank) { for (char promo : promotionPieces) addMove(state, r, c, r + direction, c, moves, promo); }
-        else { addMove(state, r, c, r + direction, c, moves); }
-        if (r == start_rank && isSquareOnBoard(r + 2 * direction, c) && state.board[r + 2 * direction][c] == EMPTY) {
-            addMove(state, r, c, r + 2 * direction, c, moves);
-        }
+template <Color Us>
+static void generatePawnMoves(const BoardState& state, int r, int c, MoveList& moves, bool capturesOnly) {
+    static const char promotionPieces[] = {Us == WHITE ? W_QUEEN : B_QUEEN, Us == WHITE ? W_ROOK : B_ROOK,
+                                           Us == WHITE ? W_BISHOP : B_BISHOP, Us == WHITE ? W_KNIGHT : B_KNIGHT};
+    const int push = Us == WHITE ? -8 : 8;
+    const int promotion_rank = Us == WHITE ? 0 : 7;
+    const int start_rank = Us == WHITE ? 6 : 1;
+    const int from = r * 8 + c;
+    const Bitboard occupied = state.occupancy[0] | state.occupancy[1];
+    Bitboard targets = pawnAttacksBB[Us][from] & state.occupancy[Us ^ 1];
+    if (!capturesOnly && !(occupied & squareBB(from + push))) {
+        targets |= squareBB(from + push);
+        if (r == start_rank && !(occupied & squareBB(from + 2 * push))) targets |= squareBB(from + 2 * push);
     }
-    for (int dc : {-1, 1}) {
-        int capture_r = r + direction; int capture_c = c + dc;
-        if (isSquareOnBoard(capture_r, capture_c)) {
-            char targetPiece = state.board[capture_r][capture_c];
-            bool canCapture = (state.whiteToMove && isBlackPiece(targetPiece)) || (!state.whiteToMove && isWhitePiece(targetPiece));
-            if (canCapture) {
-                if (capture_r == promotion_rank) { for (char promo : promotionPieces) addMove(state, r, c, capture_r, capture_c, moves, promo); }
-                else { addMove(state, r, c, capture_r, capture_c, moves); }
-            }
-            if (capture_r == state.enPassantTarget.first && capture_c == state.enPassantTarget.second && targetPiece == EMPTY) {
-                 addMove(state, r, c, capture_r, capture_c, moves, EMPTY, false, false, true);
-            }
+    while (targets) {
+        int to = popLsb(targets);
+        if (to / 8 == promotion_rank) { for (char promo : promotionPieces) moves.emplace_back(r, c, to / 8, to % 8, promo); }
+        else moves.emplace_back(r, c, to / 8, to % 8);
+    }
+    if (state.enPassantTarget.first != -1) {
+        int epSquare = state.enPassantTarget.first * 8 + state.enPassantTarget.second;
+        if ((pawnAttacksBB[Us][from] & squareBB(epSquare)) && !(occupied & squareBB(epSquare))) {
+            moves.emplace_back(r, c, epSquare / 8, epSquare % 8, EMPTY, false, false, true);
         }
     }
 }
 
-// Generate sliding piece moves (rook, bishop, queen)
-void generateSlidingMoves(const BoardState& state, int r, int c, std::vector<Move>& moves,
-                         const std::vector<std::pair<int, int>>& directions, bool capturesOnly) {
-    char piece = state.board[r][c];
-    for (auto dir : directions) {
-        for (int i = 1; i < 8; ++i) {
-            int next_r = r + dir.first * i; int next_c = c + dir.second * i;
-            if (!isSquareOnBoard(next_r, next_c)) break;
-            char targetPiece = state.board[next_r][next_c];
-            if (targetPiece == EMPTY) { if (!capturesOnly) addMove(state, r, c, next_r, next_c, moves); }
-            else {
-                if ((isWhitePiece(piece) && isBlackPiece(targetPiece)) || (isBlackPiece(piece) && isWhitePiece(targetPiece))) {
-                    addMove(state, r, c, next_r, next_c, moves);
-                }
-                break;
-            }
+// Generate king moves
+template <Color Us>
+static void generateKingMoves(const BoardState& state, int r, int c, MoveList& moves, bool capturesOnly) {
+    addMoves(r * 8 + c, kingAttacksBB[r * 8 + c] & targetSquares<Us>(state, capturesOnly), moves);
+    if (!capturesOnly) {
+        const int home = Us == WHITE ? 7 : 0;
+        const bool byEnemy = Us != WHITE; // isSquareAttacked takes the attacker's colour
+        const bool kingSide = Us == WHITE ? state.whiteKingSideCastle : state.blackKingSideCastle;
+        const bool queenSide = Us == WHITE ? state.whiteQueenSideCastle : state.blackQueenSideCastle;
+        if (kingSide && state.board[home][5]==EMPTY && state.board[home][6]==EMPTY &&
+            !isSquareAttacked(state, home, 4, byEnemy) && !isSquareAttacked(state, home, 5, byEnemy) && !isSquareAttacked(state, home, 6, byEnemy)) {
+            addMove<Us>(state, home, 4, home, 6, moves, EMPTY, true, false, false);
+        }
+        if (queenSide && state.board[home][1]==EMPTY && state.board[home][2]==EMPTY && state.board[home][3]==EMPTY &&
+            !isSquareAttacked(state, home, 4, byEnemy) && !isSquareAttacked(state, home, 3, byEnemy) && !isSquareAttacked(state, home, 2, byEnemy)) {
+            addMove<Us>(state, home, 4, home, 2, moves, EMPTY, false, true, false);
         }
     }
 }
 
-// Generate knight moves
-void generateKnightMoves(const BoardState& state, int r, int c, std::vector<Move>& moves, bool capturesOnly) {
-    const std::vector<std::pair<int, int>> knight_deltas = {{-2,-1},{-2,1},{-1,-2},{-1,2},{1,-2},{1,2},{2,-1},{2,1}};
-    for (auto d : knight_deltas) {
-        if (capturesOnly) { if(isSquareOnBoard(r+d.first, c+d.second) && getPieceAt(state, r+d.first, c+d.second) != EMPTY) addMove(state, r, c, r + d.first, c + d.second, moves); }
-        else { addMove(state, r, c, r + d.first, c + d.second, moves); }
+// Generate pseudo-legal moves of the piece on (r, c)
+template <Color Us>
+static void generatePieceMoves(const BoardState& state, int r, int c, MoveList& moves, bool capturesOnly) {
+    const int from = r * 8 + c;
+    const int piece = pieceIndex(state.board[r][c]);
+    if (piece < 0) return;
+    if (piece % 6 == 0) generatePawnMoves<Us>(state, r, c, moves, capturesOnly);
+    else if (piece % 6 == 5) generateKingMoves<Us>(state, r, c, moves, capturesOnly);
+    else {
+        // Knights and sliders
+        Bitboard occupied = state.occupancy[0] | state.occupancy[1];
+        addMoves(from, pieceAttacksBB(piece, from, occupied) & targetSquares<Us>(state, capturesOnly), moves);
     }
 }
 
-// Generate king moves
-void generateKingMoves(const BoardState& state, int r, int c, std::vector<Move>& moves, bool capturesOnly) {
-    const std::vector<std::pair<int, int>> king_deltas = {{-1,-1},{-1,0},{-1,1},{0,-1},{0,1},{1,-1},{1,0},{1,1}};
-    for (auto d : king_deltas) {
-        if (capturesOnly) { if(isSquareOnBoard(r+d.first, c+d.second) && getPieceAt(state, r+d.first, c+d.second) != EMPTY) addMove(state, r, c, r + d.first, c + d.second, moves); }
-        else { addMove(state, r, c, r + d.first, c + d.second, moves); }
+// Generate all pseudo-legal moves, square by square in board order
+template <Color Us>
+static void generateAllPseudoLegalMoves(const BoardState& state, MoveList& moves, bool capturesOnly) {
+    moves.clear();
+    for (Bitboard b = state.occupancy[Us]; b; ) {
+        int sq = popLsb(b);
+        generatePieceMoves<Us>(state, sq / 8, sq % 8, moves, capturesOnly);
     }
-    if (!capturesOnly) {
-        if (state.whiteToMove) {
-            if (state.whiteKingSideCastle && state.board[7][5]==EMPTY && state.board[7][6]==EMPTY &&
-                !isSquareAttacked(state, 7, 4, false) && !isSquareAttacked(state, 7, 5, false) && !isSquareAttacked(state, 7, 6, false)) {
-                addMove(state, 7, 4, 7, 6, moves, EMPTY, true, false, false);
-            }
-            if (state.whiteQueenSideCastle && state.board[7][1]==EMPTY && state.board[7][2]==EMPTY && state.board[7][3]==EMPTY &&
-                !isSquareAttacked(state, 7, 4, false) && !isSquareAttacked(state, 7, 3, false) && !isSquareAttacked(state, 7, 2, false)) {
-                addMove(state, 7, 4, 7, 2, moves, EMPTY, false, true, false);
-            }
-        } else {
-            if (state.blackKingSideCastle && state.board[0][5]==EMPTY && state.board[0][6]==EMPTY &&
-                !isSquareAttacked(state, 0, 4, true) && !isSquareAttacked(state, 0, 5, true) && !isSquareAttacked(state, 0, 6, true)) {
-                addMove(state, 0, 4, 0, 6, moves, EMPTY, true, false, false);
-            }
-            if (state.blackQueenSideCastle && state.board[0][1]==EMPTY && state.board[0][2]==EMPTY && state.board[0][3]==EMPTY &&
-                !isSquareAttacked(state, 0, 4, true) && !isSquareAttacked(state, 0, 3, true) && !isSquareAttacked(state, 0, 2, true)) {
-                addMove(state, 0, 4, 0, 2, moves, EMPTY, false, true, false);
-            }
-        }
+}
+
+void addMove(const BoardState& s, int r1, int c1, int r2, int c2, MoveList& m,
+             char promo, bool ksc, bool qsc, bool ep) {
+    if (s.whiteToMove) addMove<WHITE>(s, r1, c1, r2, c2, m, promo, ksc, qsc, ep);
+    else addMove<BLACK>(s, r1, c1, r2, c2, m, promo, ksc, qsc, ep);
+}
+
+void generatePawnMoves(const BoardState& state, int r, int c, MoveList& moves, bool capturesOnly) {
+    if (state.whiteToMove) generatePawnMoves<WHITE>(state, r, c, moves, capturesOnly);
+    else generatePawnMoves<BLACK>(state, r, c, moves, capturesOnly);
+}
+
+void generateKingMoves(const BoardState& state, int r, int c, MoveList& moves, bool capturesOnly) {
+    if (state.whiteToMove) generateKingMoves<WHITE>(state, r, c, moves, capturesOnly);
+    else generateKingMoves<BLACK>(state, r, c, moves, capturesOnly);
+}
+
+void generatePieceMoves(const BoardState& state, int r, int c, MoveList& moves, bool capturesOnly) {
+    if (state.whiteToMove) generatePieceMoves<WHITE>(state, r, c, moves, capturesOnly);
+    else generatePieceMoves<BLACK>(state, r, c, moves, capturesOnly);
+}
+
+void generateAllPseudoLegalMoves(const BoardState& state, MoveList& moves, bool capturesOnly) {
+    if (state.whiteToMove) generateAllPseudoLegalMoves<WHITE>(state, moves, capturesOnly);
+    else generateAllPseudoLegalMoves<BLACK>(state, moves, capturesOnly);
+}
+
+// A pseudo-legal move is legal unless it leaves the king attacked. King moves test the
+// destination with the king lifted off the board; other pieces must stay on the line of a
+// pin and, in check, capture or block a single checker. En passant is tested by making it.
+template <Color Us>
+static bool isLegalMove(const BoardState& S, const AttackInfo& info, const Move& m) {
+    const int us = Us;
+    if (!S.pieceBB[us * 6 + 5]) return true;
+    int from = m.fromRow * 8 + m.fromCol, to = m.toRow * 8 + m.toCol, ksq = kingSquare(S, us);
+    if (m.isEnPassantCapture) {
+        BoardState temp = S; apply_raw_move_to_board(temp, m);
+        return !isKingInCheck(temp, Us == WHITE);
+    }
+    if (from == ksq) {
+        if (m.isKingSideCastle || m.isQueenSideCastle) return true; // Path checked by generateKingMoves
+        Bitboard occupied = (S.occupancy[0] | S.occupancy[1]) ^ squareBB(from);
+        return (attackersTo(S, to, occupied) & S.occupancy[us ^ 1]) == 0;
     }
+    if (info.checkers) {
+        if (info.checkers & (info.checkers - 1)) return false; // Double check: only the king moves
+        if (!((betweenBB[ksq][lsbIndex(info.checkers)] | info.checkers) & squareBB(to))) return false;
+    }
+    return !(info.kingBlockers[us] & squareBB(from)) || (lineBB[ksq][from] & squareBB(to));
 }
 
-// Generate all pseudo-legal moves
-void generateAllPseudoLegalMoves(const BoardState& state, std::vector<Move>& moves, bool capturesOnly) {
-    moves.clear();
-    const std::vector<std::pair<int, int>> R_DIRS = {{0,1},{0,-1},{1,0},{-1,0}};
-    const std::vector<std::pair<int, int>> B_DIRS = {{1,1},{1,-1},{-1,1},{-1,-1}};
-    std::vector<std::pair<int, int>> Q_DIRS = R_DIRS;
-    Q_DIRS.insert(Q_DIRS.end(), B_DIRS.begin(), B_DIRS.end());
-    for (int r = 0; r < 8; ++r) {
-        for (int c = 0; c < 8; ++c) {
-            char piece = state.board[r][c];
-            if (piece == EMPTY || (state.whiteToMove != isWhitePiece(piece))) continue;
-            char upper_piece = toupper(piece);
-            if (upper_piece == W_PAWN) generatePawnMoves(state, r, c, moves, capturesOnly);
-            else if (upper_piece == W_KNIGHT) generateKnightMoves(state, r, c, moves, capturesOnly);
-            else if (upper_piece == W_BISHOP) generateSlidingMoves(state, r, c, moves, B_DIRS, capturesOnly);
-            else if (upper_piece == W_ROOK) generateSlidingMoves(state, r, c, moves, R_DIRS, capturesOnly);
-            else if (upper_piece == W_QUEEN) generateSlidingMoves(state, r, c, moves, Q_DIRS, capturesOnly);
-            else if (upper_piece == W_KING) generateKingMoves(state, r, c, moves, capturesOnly);
-        }
+// Drop the moves that leave the king in check, keeping the order of the others
+template <Color Us>
+static void filterLegal(const BoardState& S, const AttackInfo& info, MoveList& moves) {
+    int legalCount = 0;
+    for (int i = 0; i < moves.size(); ++i) {
+        if (isLegalMove<Us>(S, info, moves[i])) moves[legalCount++] = moves[i];
     }
+    moves.resize(legalCount);
 }
 
 // Generate legal moves (filters out moves that leave king in check)
-void generateLegalMoves(const BoardState& S, std::vector<Move>& legal_moves, bool capturesOnly) {
-    legal_moves.clear();
-    std::vector<Move> pseudo; generateAllPseudoLegalMoves(S, pseudo, capturesOnly);
-    bool isWhite = S.whiteToMove;
-    for (const auto& m : pseudo) {
-        BoardState temp = S; apply_raw_move_to_board(temp, m);
-        if (!isKingInCheck(temp, isWhite)) legal_moves.push_back(m);
+template <Color Us>
+static void generateLegalMoves(const BoardState& S, const AttackInfo& info, MoveList& legal_moves, bool capturesOnly) {
+    generateAllPseudoLegalMoves<Us>(S, legal_moves, capturesOnly);
+    filterLegal<Us>(S, info, legal_moves);
+}
+
+// Check evasions: king moves and, against a single checker, moves that capture it or block.
+// Pieces other than pawns that attack neither the checker nor a blocking square are skipped.
+template <Color Us>
+static void generateEvasions(const BoardState& S, const AttackInfo& info, MoveList& evasions) {
+    evasions.clear();
+    const int us = Us;
+    int ksq = kingSquare(S, us);
+    generateKingMoves<Us>(S, ksq / 8, ksq % 8, evasions, false);
+    if (!(info.checkers & (info.checkers - 1))) {
+        Bitboard target = betweenBB[ksq][lsbIndex(info.checkers)] | info.checkers;
+        for (Bitboard b = S.occupancy[us] & ~squareBB(ksq); b; ) {
+            int sq = popLsb(b);
+            if (!(S.pieceBB[us * 6] & squareBB(sq)) && !(info.attacksFrom[sq] & target)) continue;
+            generatePieceMoves<Us>(S, sq / 8, sq % 8, evasions, false);
+        }
+    }
+    filterLegal<Us>(S, info, evasions);
+}
+
+void generateLegalMoves(const BoardState& S, const AttackInfo& info, MoveList& legal_moves, bool capturesOnly) {
+    if (S.whiteToMove) generateLegalMoves<WHITE>(S, info, legal_moves, capturesOnly);
+    else generateLegalMoves<BLACK>(S, info, legal_moves, capturesOnly);
+}
+
+void generateEvasions(const BoardState& S, const AttackInfo& info, MoveList& evasions) {
+    if (S.whiteToMove) generateEvasions<WHITE>(S, info, evasions);
+    else generateEvasions<BLACK>(S, info, evasions);
+}
+
+void generateLegalMoves(const BoardState& S, MoveList& legal_moves, bool capturesOnly) {
+    AttackInfo info;
+    computeAttackInfo(S, info);
+    generateLegalMoves(S, info, legal_moves, capturesOnly);
+}
+
+// Parse a UCI move string ("e2e4", "e7e8q") into a legal move.
+// Only the moves of the piece on the from-square are generated, not the full move list.
+bool parseUciMove(const BoardState& state, const std::string& uci, Move& move) {
+    if (uci.length() < 4 || uci.length() > 5) return false;
+    int fromCol = uci[0] - 'a', fromRow = '8' - uci[1];
+    int toCol = uci[2] - 'a', toRow = '8' - uci[3];
+    if (!isSquareOnBoard(fromRow, fromCol) || !isSquareOnBoard(toRow, toCol)) return false;
+    char piece = state.board[fromRow][fromCol];
+    if (piece == EMPTY || isWhitePiece(piece) != state.whiteToMove) return false;
+
+    char promo = EMPTY;
+    if (uci.length() == 5) {
+        char promoChar = (char)tolower(uci[4]);
+        if (promoChar == 'q') promo = state.whiteToMove ? W_QUEEN : B_QUEEN;
+        else if (promoChar == 'r') promo = state.whiteToMove ? W_ROOK : B_ROOK;
+        else if (promoChar == 'b') promo = state.whiteToMove ? W_BISHOP : B_BISHOP;
+        else if (promoChar == 'n') promo = state.whiteToMove ? W_KNIGHT : B_KNIGHT;
+        else return false;
+    }
+
+    MoveList pieceMoves;
+    generatePieceMoves(state, fromRow, fromCol, pieceMoves, false);
+    for (const Move& m : pieceMoves) {
+        if (m.toRow == toRow && m.toCol == toCol && m.promotionPiece == promo) {
+            BoardState temp = state; apply_raw_move_to_board(temp, m);
+            if (isKingInCheck(temp, state.whiteToMove)) return false;
+            move = m;
+            return true;
+        }
     }
+    return false;
 }
 
-// MVV-LVA move ordering with killer moves and history heuristic
-void orderMoves(const BoardState& state, std::vector<Move>& moves, int ply) {
+// MVV-LVA move ordering with capture history, killer/counter moves and history heuristics
+void orderMoves(const BoardState& state, MoveList& moves, int ply) {
+    TimerScope timer(PROFILE_ORDERING);
+    // Previous moves for counter-move and continuation history lookups
+    const SearchStackEntry* prev1 = (ply >= 1 && ply <= MAX_SEARCH_PLY && searchStack[ply - 1].piece >= 0) ? &searchStack[ply - 1] : nullptr;
+    const SearchStackEntry* prev2 = (ply >= 2 && ply <= MAX_SEARCH_PLY + 1 && searchStack[ply - 2].piece >= 0) ? &searchStack[ply - 2] : nullptr;
+    const Move* counterMove = prev1 ? &counterMoves[prev1->piece][prev1->move.toRow * 8 + prev1->move.toCol] : nullptr;
+
     for (auto& move : moves) {
         move.score = 0;
+        int movingPiece = pieceIndex(state.board[move.fromRow][move.fromCol]);
+        int toSquare = move.toRow * 8 + move.toCol;
 
-        // 1. Captures (MVV-LVA) - highest priority
+        // 1. Captures (MVV-LVA, refined by capture history) - highest priority
         if (move.isCapture(state)) {
-            char movingPieceType = toupper(state.board[move.fromRow][move.fromCol]);
-            char capturedPieceType;
-            if (move.isEnPassantCapture) {
-                capturedPieceType = W_PAWN;
-            } else {
-                capturedPieceType = toupper(state.board[move.toRow][move.toCol]);
-            }
+            int movingPieceType = movingPiece % PIECE_TYPE_COUNT;
+            int capturedPieceType = move.isEnPassantCapture ? 0 : pieceIndex(state.board[move.toRow][move.toCol]) % PIECE_TYPE_COUNT;
 
-            int victimValue = 0;
-            auto victim_it = mvv_lva_piece_values.find(capturedPieceType);
-            if(victim_it != mvv_lva_piece_values.end()) victimValue = victim_it->second;
-
-            int attackerValue = 10;
-            auto attacker_it = mvv_lva_piece_values.find(movingPieceType);
-            if(attacker_it != mvv_lva_piece_values.end()) attackerValue = attacker_it->second;
+            int victimValue = mvv_lva_piece_values[capturedPieceType];
+            int attackerValue = mvv_lva_piece_values[movingPieceType];
 
             move.score = (victimValue * 100) - attackerValue;
+            move.score += captureHistory[movingPiece][toSquare][capturedPieceType] / CAPTURE_HISTORY_DIVISOR;
         }
 
         // 2. Promotions - very high priority
         if (move.promotionPiece != EMPTY) {
-            auto promo_it = mvv_lva_piece_values.find(toupper(move.promotionPiece));
-            if (promo_it != mvv_lva_piece_values.end()){
-                 move.score += promo_it->second * 100;
-            } else {
-                 move.score += mvv_lva_piece_values.at(W_QUEEN) * 100;
-            }
+            move.score += mvv_lva_piece_values[pieceIndex(move.promotionPiece) % PIECE_TYPE_COUNT] * 100;
         }
 
-        // 3. Killer moves (for quiet moves) - medium priority
+        // 3. Killer and counter moves (for quiet moves) - medium priority
         if (!move.isCapture(state) && move.promotionPiece == EMPTY && ply >= 0 && ply < MAX_SEARCH_PLY) {
             if (move == killerMoves[ply][0]) {
                 move.score += KILLER_MOVE_1_SCORE;
             } else if (move == killerMoves[ply][1]) {
                 move.score += KILLER_MOVE_2_SCORE;
+            } else if (counterMove && move == *counterMove) {
+                move.score += COUNTER_MOVE_SCORE;
             }
 
-            // 4. History heuristic (for quiet moves) - lower priority
+            // 4. History and continuation history (for quiet moves) - lower priority
             int fromSquare = move.fromRow * 8 + move.fromCol;
-            int toSquare = move.toRow * 8 + move.toCol;
-            move.score += historyTable[fromSquare][toSquare] / HISTORY_SCORE_DIVISOR;
+            int history = historyTable[fromSquare][toSquare];
+            if (prev1) history += continuationHistory[prev1->piece][prev1->move.toRow * 8 + prev1->move.toCol][movingPiece][toSquare];
+            if (prev2) history += continuationHistory[prev2->piece][prev2->move.toRow * 8 + prev2->move.toCol][movingPiece][toSquare];
+            move.score += history / HISTORY_SCORE_DIVISOR;
         }
     }
 
@@ -2,22 +2,29 @@
 #define MOVEGEN_H
 
 #include "types.h"
-#include <vector>
+#include <string>
+
+struct AttackInfo;
 
 // Move generation
-void generateLegalMoves(const BoardState& state, std::vector<Move>& legal_moves, bool capturesOnly = false);
-void generateAllPseudoLegalMoves(const BoardState& state, std::vector<Move>& moves, bool capturesOnly);
-void orderMoves(const BoardState& state, std::vector<Move>& moves, int ply = 0);
+void generateLegalMoves(const BoardState& state, MoveList& legal_moves, bool capturesOnly = false);
+// Same, reusing attack information already computed for the position (see attacks.h)
+void generateLegalMoves(const BoardState& state, const AttackInfo& info, MoveList& legal_moves, bool capturesOnly = false);
+// Legal moves out of check (the side to move must be in check)
+void generateEvasions(const BoardState& state, const AttackInfo& info, MoveList& evasions);
+void generateAllPseudoLegalMoves(const BoardState& state, MoveList& moves, bool capturesOnly);
+void orderMoves(const BoardState& state, MoveList& moves, int ply = 0);
+
+// Parse a UCI move string into a legal move of the side to move
+bool parseUciMove(const BoardState& state, const std::string& uci, Move& move);
 
 // Helper for adding moves
-void addMove(const BoardState& s, int r1, int c1, int r2, int c2, std::vector<Move>& m,
+void addMove(const BoardState& s, int r1, int c1, int r2, int c2, MoveList& m,
              char promo=EMPTY, bool ksc=false, bool qsc=false, bool ep=false);
 
 // Piece-specific move generation
-void generatePawnMoves(const BoardState& state, int r, int c, std::vector<Move>& moves, bool capturesOnly);
-void generateKnightMoves(const BoardState& state, int r, int c, std::vector<Move>& moves, bool capturesOnly);
-void generateSlidingMoves(const BoardState& state, int r, int c, std::vector<Move>& moves,
-                         const std::vector<std::pair<int, int>>& directions, bool capturesOnly);
-void generateKingMoves(const BoardState& state, int r, int c, std::vector<Move>& moves, bool capturesOnly);
+void generatePieceMoves(const BoardState& state, int r, int c, MoveList& moves, bool capturesOnly);
+void generatePawnMoves(const BoardState& state, int r, int c, MoveList& moves, bool capturesOnly);
+void generateKingMoves(const BoardState& state, int r, int c, MoveList& moves, bool capturesOnly);
 
 #endif // MOVEGEN_H
@@ -0,0 +1,293 @@
+#include "nnue.h"
+#include "board.h"
+#include "constants.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NNUE_X86 1
+#include <immintrin.h>
+#endif
+
+// Network parameters
+alignas(64) static int16_t featureBias[NNUE_HIDDEN];
+alignas(64) static int16_t featureWeights[NNUE_INPUTS][NNUE_HIDDEN];
+alignas(64) static int8_t outputWeights[2 * NNUE_HIDDEN];
+static int32_t outputBias = 0;
+static int32_t outputScale = 0;
+static bool networkLoaded = false;
+
+// Accumulators by Zobrist key: [0] white perspective, [1] black perspective.
+// Used by the search thread only.
+struct alignas(64) NnueAccumulator {
+    int16_t values[2][NNUE_HIDDEN];
+    uint64_t key;
+};
+static NnueAccumulator accumulatorCache[NNUE_ACCUMULATOR_CACHE_SIZE];
+
+// Input index of a piece on a square as seen from one perspective: black sees the board
+// mirrored vertically with the colours swapped, so both halves share the same weights
+static inline int featureIndex(int perspective, int piece, int square) {
+    if (perspective == 0) return piece * 64 + square;
+    return ((piece + 6) % 12) * 64 + (square ^ 56);
+}
+
+// Kernels
+
+// acc += row / acc -= row over NNUE_HIDDEN int16 values
+typedef void (*RowUpdateFn)(int16_t* acc, const int16_t* row);
+// Clipped, int8-packed dot product of both accumulator halves with the output weights
+typedef int32_t (*OutputFn)(const int16_t* us, const int16_t* them, const int8_t* weights);
+
+static void addRowScalar(int16_t* acc, const int16_t* row) {
+    for (int i = 0; i < NNUE_HIDDEN; ++i) acc[i] += row[i];
+}
+static void subRowScalar(int16_t* acc, const int16_t* row) {
+    for (int i = 0; i < NNUE_HIDDEN; ++i) acc[i] -= row[i];
+}
+static int32_t outputScalar(const int16_t* us, const int16_t* them, const int8_t* weights) {
+    int32_t sum = 0;
+    for (int i = 0; i < NNUE_HIDDEN; ++i) {
+        sum += std::min(std::max((int)us[i], 0), NNUE_ACTIVATION_MAX) * weights[i];
+        sum += std::min(std::max((int)them[i], 0), NNUE_ACTIVATION_MAX) * weights[NNUE_HIDDEN + i];
+    }
+    return sum;
+}
+
+#ifdef NNUE_X86
+__attribute__((target("sse2"))) static void addRowSse2(int16_t* acc, const int16_t* row) {
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(acc + i));
+        _mm_storeu_si128((__m128i*)(acc + i), _mm_add_epi16(a, _mm_loadu_si128((const __m128i*)(row + i))));
+    }
+}
+__attribute__((target("sse2"))) static void subRowSse2(int16_t* acc, const int16_t* row) {
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(acc + i));
+        _mm_storeu_si128((__m128i*)(acc + i), _mm_sub_epi16(a, _mm_loadu_si128((const __m128i*)(row + i))));
+    }
+}
+// SSE2 has no u8 x i8 multiply, so activations stay int16 and weights are sign-extended
+__attribute__((target("sse2"))) static int32_t dotHalfSse2(const int16_t* acc, const int8_t* weights) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(NNUE_ACTIVATION_MAX);
+    __m128i sum = _mm_setzero_si128();
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m128i a0 = _mm_min_epi16(_mm_max_epi16(_mm_loadu_si128((const __m128i*)(acc + i)), zero), max);
+        __m128i a1 = _mm_min_epi16(_mm_max_epi16(_mm_loadu_si128((const __m128i*)(acc + i + 8)), zero), max);
+        __m128i w = _mm_loadu_si128((const __m128i*)(weights + i));
+        __m128i sign = _mm_cmpgt_epi8(zero, w);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(a0, _mm_unpacklo_epi8(w, sign)));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(a1, _mm_unpackhi_epi8(w, sign)));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+}
+__attribute__((target("sse2"))) static int32_t outputSse2(const int16_t* us, const int16_t* them, const int8_t* weights) {
+    return dotHalfSse2(us, weights) + dotHalfSse2(them, weights + NNUE_HIDDEN);
+}
+
+__attribute__((target("avx2"))) static void addRowAvx2(int16_t* acc, const int16_t* row) {
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(acc + i));
+        _mm256_storeu_si256((__m256i*)(acc + i), _mm256_add_epi16(a, _mm256_loadu_si256((const __m256i*)(row + i))));
+    }
+}
+__attribute__((target("avx2"))) static void subRowAvx2(int16_t* acc, const int16_t* row) {
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(acc + i));
+        _mm256_storeu_si256((__m256i*)(acc + i), _mm256_sub_epi16(a, _mm256_loadu_si256((const __m256i*)(row + i))));
+    }
+}
+// Clip to [0, 127], pack to u8 (packs interleaves 128-bit lanes, the permute restores order)
+// and multiply with the int8 weights; pairs cannot saturate since 2 * 127 * 128 < 32768
+__attribute__((target("avx2"))) static int32_t dotHalfAvx2(const int16_t* acc, const int8_t* weights) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi16(NNUE_ACTIVATION_MAX);
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < NNUE_HIDDEN; i += 32) {
+        __m256i a0 = _mm256_min_epi16(_mm256_max_epi16(_mm256_loadu_si256((const __m256i*)(acc + i)), zero), max);
+        __m256i a1 = _mm256_min_epi16(_mm256_max_epi16(_mm256_loadu_si256((const __m256i*)(acc + i + 16)), zero), max);
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(a0, a1), 0xD8);
+        __m256i products = _mm256_maddubs_epi16(packed, _mm256_loadu_si256((const __m256i*)(weights + i)));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+    }
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    return _mm_cvtsi128_si32(s);
+}
+__attribute__((target("avx2"))) static int32_t outputAvx2(const int16_t* us, const int16_t* them, const int8_t* weights) {
+    return dotHalfAvx2(us, weights) + dotHalfAvx2(them, weights + NNUE_HIDDEN);
+}
+
+__attribute__((target("avx512f,avx512bw"))) static void addRowAvx512(int16_t* acc, const int16_t* row) {
+    for (int i = 0; i < NNUE_HIDDEN; i += 32) {
+        __m512i a = _mm512_loadu_si512((const void*)(acc + i));
+        _mm512_storeu_si512((void*)(acc + i), _mm512_add_epi16(a, _mm512_loadu_si512((const void*)(row + i))));
+    }
+}
+__attribute__((target("avx512f,avx512bw"))) static void subRowAvx512(int16_t* acc, const int16_t* row) {
+    for (int i = 0; i < NNUE_HIDDEN; i += 32) {
+        __m512i a = _mm512_loadu_si512((const void*)(acc + i));
+        _mm512_storeu_si512((void*)(acc + i), _mm512_sub_epi16(a, _mm512_loadu_si512((const void*)(row + i))));
+    }
+}
+__attribute__((target("avx512f,avx512bw"))) static int32_t dotHalfAvx512(const int16_t* acc, const int8_t* weights) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i max = _mm512_set1_epi16(NNUE_ACTIVATION_MAX);
+    const __m512i ones = _mm512_set1_epi16(1);
+    const __m512i order = _mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7);
+    __m512i sum = _mm512_setzero_si512();
+    for (int i = 0; i < NNUE_HIDDEN; i += 64) {
+        __m512i a0 = _mm512_min_epi16(_mm512_max_epi16(_mm512_loadu_si512((const void*)(acc + i)), zero), max);
+        __m512i a1 = _mm512_min_epi16(_mm512_max_epi16(_mm512_loadu_si512((const void*)(acc + i + 32)), zero), max);
+        __m512i packed = _mm512_maskz_permutexvar_epi64(0xFF, order, _mm512_packs_epi16(a0, a1));
+        __m512i products = _mm512_maddubs_epi16(packed, _mm512_loadu_si512((const void*)(weights + i)));
+        sum = _mm512_add_epi32(sum, _mm512_madd_epi16(products, ones));
+    }
+    // Masked forms: the plain ones start from _mm512_undefined, which GCC 12 warns about
+    __m256i half = _mm256_add_epi32(_mm512_maskz_extracti64x4_epi64(0xF, sum, 0), _mm512_maskz_extracti64x4_epi64(0xF, sum, 1));
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(half), _mm256_extracti128_si256(half, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    return _mm_cvtsi128_si32(s);
+}
+__attribute__((target("avx512f,avx512bw"))) static int32_t outputAvx512(const int16_t* us, const int16_t* them, const int8_t* weights) {
+    return dotHalfAvx512(us, weights) + dotHalfAvx512(them, weights + NNUE_HIDDEN);
+}
+#endif // NNUE_X86
+
+static RowUpdateFn addRow = addRowScalar;
+static RowUpdateFn subRow = subRowScalar;
+static OutputFn outputLayer = outputScalar;
+static NnueSimd activeKernels = NNUE_SCALAR;
+static bool kernelsSelected = false;
+
+NnueSimd selectNnueKernels(NnueSimd maxLevel) {
+    addRow = addRowScalar; subRow = subRowScalar; outputLayer = outputScalar;
+    activeKernels = NNUE_SCALAR;
+    kernelsSelected = true;
+#ifdef NNUE_X86
+    __builtin_cpu_init();
+    if (maxLevel >= NNUE_AVX512 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        addRow = addRowAvx512; subRow = subRowAvx512; outputLayer = outputAvx512;
+        activeKernels = NNUE_AVX512;
+    } else if (maxLevel >= NNUE_AVX2 && __builtin_cpu_supports("avx2")) {
+        addRow = addRowAvx2; subRow = subRowAvx2; outputLayer = outputAvx2;
+        activeKernels = NNUE_AVX2;
+    } else if (maxLevel >= NNUE_SSE2 && __builtin_cpu_supports("sse2")) {
+        addRow = addRowSse2; subRow = subRowSse2; outputLayer = outputSse2;
+        activeKernels = NNUE_SSE2;
+    }
+#else
+    (void)maxLevel;
+#endif
+    return activeKernels;
+}
+
+const char* nnueKernelName() {
+    switch (activeKernels) {
+        case NNUE_AVX512: return "avx512";
+        case NNUE_AVX2: return "avx2";
+        case NNUE_SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+bool nnueLoaded() { return networkLoaded; }
+
+bool loadNnue(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Warning: Could not open NNUE file: " << path << std::endl;
+        return false;
+    }
+
+    NnueFileHeader header;
+    const char* problem = nullptr;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) problem = "file too small";
+    else if (std::memcmp(header.magic, NNUE_FILE_MAGIC, sizeof(header.magic)) != 0) problem = "not a network file";
+    else if (header.version != NNUE_FILE_VERSION) problem = "unsupported version";
+    else if (header.byteOrder != TT_FILE_BYTE_ORDER) problem = "different byte order";
+    else if (header.inputs != (uint32_t)NNUE_INPUTS || header.hidden != (uint32_t)NNUE_HIDDEN) problem = "different network shape";
+    if (problem) {
+        std::cerr << "Warning: Incompatible NNUE file (" << problem << "): " << path << std::endl;
+        return false;
+    }
+
+    // Read into a staging copy so that a truncated file leaves the current network intact
+    struct NetworkParameters {
+        int16_t featureBias[NNUE_HIDDEN];
+        int16_t featureWeights[NNUE_INPUTS][NNUE_HIDDEN];
+        int8_t outputWeights[2 * NNUE_HIDDEN];
+        int32_t outputBias;
+    };
+    std::unique_ptr<NetworkParameters> staged(new NetworkParameters);
+    file.read(reinterpret_cast<char*>(staged->featureBias), sizeof(staged->featureBias));
+    file.read(reinterpret_cast<char*>(staged->featureWeights), sizeof(staged->featureWeights));
+    file.read(reinterpret_cast<char*>(staged->outputWeights), sizeof(staged->outputWeights));
+    file.read(reinterpret_cast<char*>(&staged->outputBias), sizeof(staged->outputBias));
+    if (!file || file.peek() != std::char_traits<char>::eof()) {
+        std::cerr << "Warning: Incompatible NNUE file (bad size): " << path << std::endl;
+        return false;
+    }
+    std::memcpy(featureBias, staged->featureBias, sizeof(featureBias));
+    std::memcpy(featureWeights, staged->featureWeights, sizeof(featureWeights));
+    std::memcpy(outputWeights, staged->outputWeights, sizeof(outputWeights));
+    outputBias = staged->outputBias;
+    outputScale = header.outputScale;
+
+    for (size_t i = 0; i < NNUE_ACCUMULATOR_CACHE_SIZE; ++i) accumulatorCache[i].key = 0;
+    if (!kernelsSelected) selectNnueKernels(NNUE_AVX512);
+    networkLoaded = true;
+    return true;
+}
+
+// Build both accumulator halves from the board
+static void refreshAccumulator(const BoardState& state, NnueAccumulator& acc) {
+    std::memcpy(acc.values[0], featureBias, sizeof(featureBias));
+    std::memcpy(acc.values[1], featureBias, sizeof(featureBias));
+    for (int r = 0; r < 8; ++r) {
+        for (int c = 0; c < 8; ++c) {
+            int p = pieceIndex(state.board[r][c]);
+            if (p < 0) continue;
+            addRow(acc.values[0], featureWeights[featureIndex(0, p, r * 8 + c)]);
+            addRow(acc.values[1], featureWeights[featureIndex(1, p, r * 8 + c)]);
+        }
+    }
+}
+
+// Accumulator of 'state': cached, derived from the parent's with the dirty pieces, or rebuilt
+static const NnueAccumulator& accumulatorFor(const BoardState& state) {
+    NnueAccumulator& acc = accumulatorCache[state.hashKey & (NNUE_ACCUMULATOR_CACHE_SIZE - 1)];
+    if (acc.key == state.hashKey) return acc;
+
+    const NnueAccumulator& parent = accumulatorCache[state.parentKey & (NNUE_ACCUMULATOR_CACHE_SIZE - 1)];
+    if (state.parentKey != 0 && parent.key == state.parentKey) {
+        if (&parent != &acc) std::memcpy(acc.values, parent.values, sizeof(acc.values));
+        for (int i = 0; i < state.dirtyCount; ++i) {
+            const DirtyPiece& dp = state.dirtyPieces[i];
+            RowUpdateFn update = dp.added ? addRow : subRow;
+            update(acc.values[0], featureWeights[featureIndex(0, dp.piece, dp.square)]);
+            update(acc.values[1], featureWeights[featureIndex(1, dp.piece, dp.square)]);
+        }
+    } else {
+        refreshAccumulator(state, acc);
+    }
+    acc.key = state.hashKey;
+    return acc;
+}
+
+int nnueEvaluate(const BoardState& state) {
+    const NnueAccumulator& acc = accumulatorFor(state);
+    int us = state.whiteToMove ? 0 : 1;
+    int32_t dot = outputLayer(acc.values[us], acc.values[us ^ 1], outputWeights);
+    int score = (int)(((int64_t)dot + outputBias) * outputScale / NNUE_OUTPUT_DIVISOR);
+    return state.whiteToMove ? score : -score;
+}
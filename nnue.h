@@ -0,0 +1,51 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include "types.h"
+#include <cstdint>
+#include <string>
+
+// NNUE Evaluation
+// Efficiently updatable network: 768 piece-square inputs per perspective feed a hidden
+// layer of NNUE_HIDDEN int16 accumulators, the side to move's half first. Accumulators
+// are clipped to [0, NNUE_ACTIVATION_MAX], packed to int8 and dotted with int8 output
+// weights. Accumulators are cached by Zobrist key and updated from the parent position
+// with the pieces changed by the last move (BoardState::dirtyPieces), so most evals
+// only add and subtract a few weight rows.
+//
+// Network file (little-endian, NnueFileHeader then):
+//   int16 featureBias[NNUE_HIDDEN]
+//   int16 featureWeights[NNUE_INPUTS][NNUE_HIDDEN]  (input = piece index * 64 + square,
+//                                                    seen from white; black mirrors both)
+//   int8  outputWeights[2 * NNUE_HIDDEN]            (side to move, then the other side)
+//   int32 outputBias
+// eval (centipawns, side to move) = (dot + outputBias) * outputScale / NNUE_OUTPUT_DIVISOR
+
+struct NnueFileHeader {
+    char magic[8];       // NNUE_FILE_MAGIC
+    uint32_t version;    // NNUE_FILE_VERSION
+    uint32_t byteOrder;  // TT_FILE_BYTE_ORDER as written by the exporting machine
+    uint32_t inputs;     // NNUE_INPUTS
+    uint32_t hidden;     // NNUE_HIDDEN
+    int32_t outputScale;
+    uint32_t padding;
+};
+
+// SIMD kernel sets, in increasing order of preference
+enum NnueSimd { NNUE_SCALAR, NNUE_SSE2, NNUE_AVX2, NNUE_AVX512 };
+
+// Load a network file, replacing any loaded network. Errors are reported on stderr and return
+// false; the previously loaded network, if any, is then left in place.
+bool loadNnue(const std::string& path);
+
+// True once a network has been loaded
+bool nnueLoaded();
+
+// Evaluate from white's perspective with the loaded network
+int nnueEvaluate(const BoardState& state);
+
+// Select the best kernel set supported by the CPU, capped at 'maxLevel'; returns the one chosen
+NnueSimd selectNnueKernels(NnueSimd maxLevel);
+const char* nnueKernelName();
+
+#endif // NNUE_H
@@ -1,17 +1,120 @@
 #include "pawn_structure.h"
+#include "bitboard.h"
 #include "board.h"
 #include "constants.h"
+#include "profile.h"
+#include <cstring>
+
+// Precomputed pawn masks, indexed [side][square] with side 0 = white, 1 = black
+static Bitboard fileMaskBB[8];
+static Bitboard adjacentFilesBB[8];
+static Bitboard forwardSpanBB[2][64];     // Same file, strictly ahead
+static Bitboard passedPawnMaskBB[2][64];  // Same and adjacent files, strictly ahead
+static Bitboard adjacentForwardBB[2][64]; // Adjacent files, strictly ahead
+static Bitboard connectedMaskBB[64];      // Adjacent files, one row behind to one row ahead
+static Bitboard frontAttackersBB[2][64];  // Enemy pawn squares attacking the square in front
+
+static void initPawnMasks() {
+    for (int col = 0; col < 8; col++) fileMaskBB[col] = FILE_A_BB << col;
+    for (int col = 0; col < 8; col++) {
+        adjacentFilesBB[col] = (col > 0 ? fileMaskBB[col - 1] : 0) | (col < 7 ? fileMaskBB[col + 1] : 0);
+    }
+    for (int sq = 0; sq < 64; sq++) {
+        int row = sq / 8, col = sq % 8;
+        Bitboard rowsAbove = (row > 0) ? (~0ULL >> (64 - 8 * row)) : 0; // rows < row
+        Bitboard rowsBelow = (row < 7) ? (~0ULL << (8 * (row + 1))) : 0; // rows > row
+        forwardSpanBB[0][sq] = fileMaskBB[col] & rowsAbove;
+        forwardSpanBB[1][sq] = fileMaskBB[col] & rowsBelow;
+        adjacentForwardBB[0][sq] = adjacentFilesBB[col] & rowsAbove;
+        adjacentForwardBB[1][sq] = adjacentFilesBB[col] & rowsBelow;
+        passedPawnMaskBB[0][sq] = forwardSpanBB[0][sq] | adjacentForwardBB[0][sq];
+        passedPawnMaskBB[1][sq] = forwardSpanBB[1][sq] | adjacentForwardBB[1][sq];
+
+        Bitboard nearRows = ROW_0_BB << (8 * row);
+        if (row > 0) nearRows |= ROW_0_BB << (8 * (row - 1));
+        if (row < 7) nearRows |= ROW_0_BB << (8 * (row + 1));
+        connectedMaskBB[sq] = adjacentFilesBB[col] & nearRows;
+
+        frontAttackersBB[0][sq] = (row >= 2) ? adjacentFilesBB[col] & (ROW_0_BB << (8 * (row - 2))) : 0;
+        frontAttackersBB[1][sq] = (row <= 5) ? adjacentFilesBB[col] & (ROW_0_BB << (8 * (row + 2))) : 0;
+    }
+}
 
-// Main pawn structure evaluation function
-int evaluatePawnStructure(const BoardState& state) {
-    int score = 0;
+static struct PawnMaskInitializer { PawnMaskInitializer() { initPawnMasks(); } } pawnMaskInitializer;
+
+// Squares attacked by the pawns of one side
+static Bitboard pawnAttacks(Bitboard pawns, int side) {
+    return side == 0 ? shiftNorth(shiftEast(pawns) | shiftWest(pawns))
+                     : shiftSouth(shiftEast(pawns) | shiftWest(pawns));
+}
+
+// Passed pawns of one side: no enemy pawn ahead on the same or an adjacent file
+static Bitboard passedPawnSet(const BoardState& state, int side) {
+    Bitboard enemySpan = side == 0 ? southSpan(state.pieceBB[6]) : northSpan(state.pieceBB[0]);
+    Bitboard blocked = enemySpan | shiftEast(enemySpan) | shiftWest(enemySpan);
+    return state.pieceBB[side * 6] & ~blocked;
+}
+
+// Backward candidates of one side: the square in front is attacked by an enemy pawn and a
+// friendly pawn stands further ahead on an adjacent file (see isBackwardPawnCandidate)
+static Bitboard backwardCandidateSet(const BoardState& state, int side) {
+    Bitboard own = state.pieceBB[side * 6];
+    Bitboard enemyAttacks = pawnAttacks(state.pieceBB[(side ^ 1) * 6], side ^ 1);
+    Bitboard frontAttacked = side == 0 ? shiftSouth(enemyAttacks) : shiftNorth(enemyAttacks);
+    Bitboard behindOwn = side == 0 ? southSpan(own) : northSpan(own);
+    return own & frontAttacked & (shiftEast(behindOwn) | shiftWest(behindOwn));
+}
+
+// Pawn hash table
+static PawnEntry pawnHashTable[PAWN_HASH_SIZE];
+
+void clearPawnHash() {
+    std::memset(pawnHashTable, 0, sizeof(pawnHashTable));
+}
+
+// Fill a pawn hash entry. Everything here depends on pawns only; the backward pawn
+// term also needs the square in front to be empty, so only its candidates are cached.
+static void computePawnEntry(const BoardState& state, PawnEntry& entry) {
+    entry.key = state.pawnKey;
+    entry.valid = true;
+    entry.score = evaluateDoubledPawns(state) + evaluateIsolatedPawns(state) + evaluatePassedPawns(state) +
+                  evaluateConnectedPawns(state) + evaluatePawnChains(state);
+    uint8_t whiteFiles = 0, blackFiles = 0;
+    for (int col = 0; col < 8; col++) {
+        if (state.pieceBB[0] & fileMaskBB[col]) whiteFiles |= (uint8_t)(1 << col);
+        if (state.pieceBB[6] & fileMaskBB[col]) blackFiles |= (uint8_t)(1 << col);
+    }
+    for (int side = 0; side < 2; side++) {
+        entry.passedPawns[side] = passedPawnSet(state, side);
+        entry.backwardCandidates[side] = backwardCandidateSet(state, side);
+    }
+    entry.openFiles = (uint8_t)~(whiteFiles | blackFiles);
+    entry.semiOpenFiles[0] = (uint8_t)~whiteFiles;
+    entry.semiOpenFiles[1] = (uint8_t)~blackFiles;
+}
 
-    score += evaluateDoubledPawns(state);
-    score += evaluateIsolatedPawns(state);
-    score += evaluatePassedPawns(state);
-    score += evaluateConnectedPawns(state);
-    score += evaluateBackwardPawns(state);
-    score += evaluatePawnChains(state);
+const PawnEntry& probePawnHash(const BoardState& state) {
+    PawnEntry& entry = pawnHashTable[state.pawnKey & (PAWN_HASH_SIZE - 1)];
+    if (!entry.valid || entry.key != state.pawnKey) computePawnEntry(state, entry);
+    return entry;
+}
+
+// Main pawn structure evaluation function (cached in the pawn hash table)
+int evaluatePawnStructure(const BoardState& state) {
+    TimerScope timer(PROFILE_PAWN_EVAL);
+    const PawnEntry& entry = probePawnHash(state);
+    int score = entry.score;
+
+    // Backward pawns: cached candidates whose square in front is empty
+    for (int side = 0; side < 2; side++) {
+        int direction = (side == 0) ? -1 : 1;
+        for (Bitboard candidates = entry.backwardCandidates[side]; candidates; ) {
+            int sq = popLsb(candidates);
+            if (state.board[sq / 8 + direction][sq % 8] == EMPTY) {
+                score += (side == 0) ? BACKWARD_PAWN_PENALTY : -BACKWARD_PAWN_PENALTY;
+            }
+        }
+    }
 
     return score;
 }
@@ -21,14 +124,8 @@ int evaluateDoubledPawns(const BoardState& state) {
     int score = 0;
 
     for (int col = 0; col < 8; col++) {
-        int whitePawns = 0;
-        int blackPawns = 0;
-
-        // Count pawns on this file
-        for (int row = 0; row < 8; row++) {
-            if (state.board[row][col] == W_PAWN) whitePawns++;
-            if (state.board[row][col] == B_PAWN) blackPawns++;
-        }
+        int whitePawns = popCount(state.pieceBB[0] & fileMaskBB[col]);
+        int blackPawns = popCount(state.pieceBB[6] & fileMaskBB[col]);
 
         // Penalize doubled (and tripled!) pawns
         if (whitePawns > 1) {
@@ -44,37 +141,18 @@ int evaluateDoubledPawns(const BoardState& state) {
 
 // Check if a pawn is isolated (no friendly pawns on adjacent files)
 bool isIsolatedPawn(const BoardState& state, int col, bool isWhite) {
-    char pawn = isWhite ? W_PAWN : B_PAWN;
-
-    // Check left and right adjacent files for friendly pawns
-    for (int adjacentCol : {col - 1, col + 1}) {
-        if (adjacentCol < 0 || adjacentCol >= 8) continue;
-
-        for (int r = 0; r < 8; r++) {
-            if (state.board[r][adjacentCol] == pawn) {
-                return false; // Found a friendly pawn on adjacent file
-            }
-        }
-    }
-
-    return true; // No friendly pawns on adjacent files
+    return (state.pieceBB[isWhite ? 0 : 6] & adjacentFilesBB[col]) == 0;
 }
 
 // Evaluate isolated pawns
 int evaluateIsolatedPawns(const BoardState& state) {
     int score = 0;
 
-    for (int row = 0; row < 8; row++) {
-        for (int col = 0; col < 8; col++) {
-            char piece = state.board[row][col];
-
-            if (piece == W_PAWN && isIsolatedPawn(state, col, true)) {
-                score += ISOLATED_PAWN_PENALTY;
-            }
-            if (piece == B_PAWN && isIsolatedPawn(state, col, false)) {
-                score -= ISOLATED_PAWN_PENALTY;
-            }
-        }
+    for (int side = 0; side < 2; side++) {
+        Bitboard own = state.pieceBB[side * 6];
+        Bitboard files = northSpan(own) | southSpan(own) | own;
+        Bitboard isolated = own & ~(shiftEast(files) | shiftWest(files));
+        score += (side == 0 ? 1 : -1) * ISOLATED_PAWN_PENALTY * popCount(isolated);
     }
 
     return score;
@@ -82,49 +160,24 @@ int evaluateIsolatedPawns(const BoardState& state) {
 
 // Check if a pawn is passed (no enemy pawns blocking its path to promotion)
 bool isPassedPawn(const BoardState& state, int row, int col, bool isWhite) {
-    char enemyPawn = isWhite ? B_PAWN : W_PAWN;
-    int direction = isWhite ? -1 : 1; // White pawns move up (row decreases), black down
-
-    // Check the pawn's file and adjacent files ahead
-    for (int checkCol = col - 1; checkCol <= col + 1; checkCol++) {
-        if (checkCol < 0 || checkCol >= 8) continue;
-
-        // Check all squares ahead on this file
-        for (int checkRow = row + direction;
-             checkRow >= 0 && checkRow < 8;
-             checkRow += direction) {
-
-            if (state.board[checkRow][checkCol] == enemyPawn) {
-                return false; // Enemy pawn blocks the path
-            }
-        }
-    }
-
-    return true; // No enemy pawns blocking
+    int side = isWhite ? 0 : 1;
+    return (state.pieceBB[(side ^ 1) * 6] & passedPawnMaskBB[side][row * 8 + col]) == 0;
 }
 
 // Evaluate passed pawns (bonus increases with advancement)
 int evaluatePassedPawns(const BoardState& state) {
     int score = 0;
 
-    for (int row = 0; row < 8; row++) {
-        for (int col = 0; col < 8; col++) {
-            char piece = state.board[row][col];
-
-            if (piece == W_PAWN && isPassedPawn(state, row, col, true)) {
-                // White pawns: rank 0 is 8th rank, rank 7 is 1st rank
-                int rank = 7 - row; // Convert to rank from white's perspective (0-7)
-                int bonus = PASSED_PAWN_BASE + (rank * PASSED_PAWN_RANK_BONUS);
-                score += bonus;
-            }
+    // White pawns: row 0 is the 8th rank, so the rank from white's perspective is 7 - row
+    for (Bitboard passed = passedPawnSet(state, 0); passed; ) {
+        int rank = 7 - popLsb(passed) / 8;
+        score += PASSED_PAWN_BASE + (rank * PASSED_PAWN_RANK_BONUS);
+    }
 
-            if (piece == B_PAWN && isPassedPawn(state, row, col, false)) {
-                // Black pawns: rank 0 is 1st rank (from black's perspective)
-                int rank = row; // Rank from black's perspective (0-7)
-                int bonus = PASSED_PAWN_BASE + (rank * PASSED_PAWN_RANK_BONUS);
-                score -= bonus;
-            }
-        }
+    // Black pawns: the row is the rank from black's perspective
+    for (Bitboard passed = passedPawnSet(state, 1); passed; ) {
+        int rank = popLsb(passed) / 8;
+        score -= PASSED_PAWN_BASE + (rank * PASSED_PAWN_RANK_BONUS);
     }
 
     return score;
@@ -132,42 +185,18 @@ int evaluatePassedPawns(const BoardState& state) {
 
 // Check if a pawn has a connected (adjacent) friendly pawn
 bool hasConnectedPawn(const BoardState& state, int row, int col, bool isWhite) {
-    char pawn = isWhite ? W_PAWN : B_PAWN;
-
-    // Check adjacent files on same row or one row away
-    for (int dCol = -1; dCol <= 1; dCol += 2) { // -1 and +1
-        int adjCol = col + dCol;
-        if (adjCol < 0 || adjCol >= 8) continue;
-
-        // Check same row and one row forward/backward
-        for (int dRow = -1; dRow <= 1; dRow++) {
-            int adjRow = row + dRow;
-            if (adjRow < 0 || adjRow >= 8) continue;
-
-            if (state.board[adjRow][adjCol] == pawn) {
-                return true;
-            }
-        }
-    }
-
-    return false;
+    return (state.pieceBB[isWhite ? 0 : 6] & connectedMaskBB[row * 8 + col]) != 0;
 }
 
-// Evaluate connected pawns
+// Evaluate connected pawns (friendly pawn on an adjacent file, at most one row away)
 int evaluateConnectedPawns(const BoardState& state) {
     int score = 0;
 
-    for (int row = 0; row < 8; row++) {
-        for (int col = 0; col < 8; col++) {
-            char piece = state.board[row][col];
-
-            if (piece == W_PAWN && hasConnectedPawn(state, row, col, true)) {
-                score += CONNECTED_PAWN_BONUS;
-            }
-            if (piece == B_PAWN && hasConnectedPawn(state, row, col, false)) {
-                score -= CONNECTED_PAWN_BONUS;
-            }
-        }
+    for (int side = 0; side < 2; side++) {
+        Bitboard own = state.pieceBB[side * 6];
+        Bitboard nearRows = own | shiftNorth(own) | shiftSouth(own);
+        Bitboard connected = own & (shiftEast(nearRows) | shiftWest(nearRows));
+        score += (side == 0 ? 1 : -1) * CONNECTED_PAWN_BONUS * popCount(connected);
     }
 
     return score;
@@ -175,12 +204,7 @@ int evaluateConnectedPawns(const BoardState& state) {
 
 // Check if a pawn is backward (can't safely advance and is behind friendly pawns)
 bool isBackwardPawn(const BoardState& state, int row, int col, bool isWhite) {
-    char pawn = isWhite ? W_PAWN : B_PAWN;
-    char enemyPawn = isWhite ? B_PAWN : W_PAWN;
-    int direction = isWhite ? -1 : 1;
-
-    // Check if pawn can safely advance
-    int nextRow = row + direction;
+    int nextRow = row + (isWhite ? -1 : 1);
     if (nextRow < 0 || nextRow >= 8) return false;
 
     // If square ahead is occupied by friendly piece, not backward
@@ -188,48 +212,28 @@ bool isBackwardPawn(const BoardState& state, int row, int col, bool isWhite) {
         return false;
     }
 
-    // Check if advancing would be safe (no enemy pawns attacking next square)
-    for (int attackCol = col - 1; attackCol <= col + 1; attackCol += 2) {
-        if (attackCol < 0 || attackCol >= 8) continue;
-
-        int enemyRow = nextRow + direction;
-        if (enemyRow >= 0 && enemyRow < 8) {
-            if (state.board[enemyRow][attackCol] == enemyPawn) {
-                // Pawn would be attacked if it advances
-                // Now check if it's behind pawns on adjacent files
-                for (int adjCol : {col - 1, col + 1}) {
-                    if (adjCol < 0 || adjCol >= 8) continue;
-
-                    // Look for friendly pawns ahead on adjacent files
-                    for (int checkRow = row + direction;
-                         checkRow >= 0 && checkRow < 8;
-                         checkRow += direction) {
-
-                        if (state.board[checkRow][adjCol] == pawn) {
-                            return true; // Backward: can't advance and behind friendly pawns
-                        }
-                    }
-                }
-            }
-        }
-    }
+    return isBackwardPawnCandidate(state, row, col, isWhite);
+}
 
-    return false;
+// Pawn-only part of isBackwardPawn (ignores whether the square ahead is occupied):
+// an enemy pawn attacks the square ahead and a friendly pawn is further ahead on an adjacent file
+bool isBackwardPawnCandidate(const BoardState& state, int row, int col, bool isWhite) {
+    int side = isWhite ? 0 : 1;
+    int sq = row * 8 + col;
+    return (state.pieceBB[(side ^ 1) * 6] & frontAttackersBB[side][sq]) != 0 &&
+           (state.pieceBB[side * 6] & adjacentForwardBB[side][sq]) != 0;
 }
 
 // Evaluate backward pawns
 int evaluateBackwardPawns(const BoardState& state) {
     int score = 0;
 
-    for (int row = 0; row < 8; row++) {
-        for (int col = 0; col < 8; col++) {
-            char piece = state.board[row][col];
-
-            if (piece == W_PAWN && isBackwardPawn(state, row, col, true)) {
-                score += BACKWARD_PAWN_PENALTY;
-            }
-            if (piece == B_PAWN && isBackwardPawn(state, row, col, false)) {
-                score -= BACKWARD_PAWN_PENALTY;
+    for (int side = 0; side < 2; side++) {
+        int direction = (side == 0) ? -1 : 1;
+        for (Bitboard candidates = backwardCandidateSet(state, side); candidates; ) {
+            int sq = popLsb(candidates);
+            if (state.board[sq / 8 + direction][sq % 8] == EMPTY) {
+                score += (side == 0) ? BACKWARD_PAWN_PENALTY : -BACKWARD_PAWN_PENALTY;
             }
         }
     }
@@ -237,42 +241,17 @@ int evaluateBackwardPawns(const BoardState& state) {
     return score;
 }
 
-// Evaluate pawn chains (diagonal chains of pawns)
+// Evaluate pawn chains (one bonus per friendly pawn diagonally behind a pawn)
 int evaluatePawnChains(const BoardState& state) {
     int score = 0;
 
-    for (int row = 0; row < 8; row++) {
-        for (int col = 0; col < 8; col++) {
-            char piece = state.board[row][col];
-
-            if (piece == W_PAWN) {
-                // Check if white pawn has supporting pawn diagonally behind
-                for (int dCol = -1; dCol <= 1; dCol += 2) {
-                    int supportCol = col + dCol;
-                    int supportRow = row + 1; // Behind for white
-
-                    if (supportRow < 8 && supportCol >= 0 && supportCol < 8) {
-                        if (state.board[supportRow][supportCol] == W_PAWN) {
-                            score += PAWN_CHAIN_BONUS;
-                        }
-                    }
-                }
-            }
-
-            if (piece == B_PAWN) {
-                // Check if black pawn has supporting pawn diagonally behind
-                for (int dCol = -1; dCol <= 1; dCol += 2) {
-                    int supportCol = col + dCol;
-                    int supportRow = row - 1; // Behind for black
-
-                    if (supportRow >= 0 && supportCol >= 0 && supportCol < 8) {
-                        if (state.board[supportRow][supportCol] == B_PAWN) {
-                            score -= PAWN_CHAIN_BONUS;
-                        }
-                    }
-                }
-            }
-        }
+    for (int side = 0; side < 2; side++) {
+        Bitboard own = state.pieceBB[side * 6];
+        // Squares defended by a pawn from the east and from the west, counted separately
+        Bitboard fromWest = side == 0 ? shiftNorth(shiftEast(own)) : shiftSouth(shiftEast(own));
+        Bitboard fromEast = side == 0 ? shiftNorth(shiftWest(own)) : shiftSouth(shiftWest(own));
+        int supports = popCount(own & fromWest) + popCount(own & fromEast);
+        score += (side == 0 ? 1 : -1) * PAWN_CHAIN_BONUS * supports;
     }
 
     return score;
@@ -12,9 +12,28 @@ const int CONNECTED_PAWN_BONUS = 5;
 const int BACKWARD_PAWN_PENALTY = -10;
 const int PAWN_CHAIN_BONUS = 8;
 
+// Pawn hash table size (entries, power of two)
+const int PAWN_HASH_SIZE = 16384;
+
+// Cached pawn-structure data for one pawn configuration, keyed by BoardState::pawnKey.
+// Squares in the bitsets are row * 8 + col; index [0] is white, [1] black.
+struct PawnEntry {
+    uint64_t key;
+    bool valid;
+    int score;                      // Pawn terms except backward pawns, white's perspective
+    uint64_t passedPawns[2];
+    uint64_t backwardCandidates[2]; // Backward pawns, provided the square in front is empty
+    uint8_t openFiles;              // Bit per file with no pawns
+    uint8_t semiOpenFiles[2];       // Bit per file with no pawns of that side
+};
+
 // Main evaluation function
 int evaluatePawnStructure(const BoardState& state);
 
+// Pawn hash table: returns the cached entry for the position's pawns, computing it on a miss
+const PawnEntry& probePawnHash(const BoardState& state);
+void clearPawnHash();
+
 // Individual pawn structure evaluations
 int evaluateDoubledPawns(const BoardState& state);
 int evaluateIsolatedPawns(const BoardState& state);
@@ -27,6 +46,7 @@ int evaluatePawnChains(const BoardState& state);
 bool isPassedPawn(const BoardState& state, int row, int col, bool isWhite);
 bool isIsolatedPawn(const BoardState& state, int col, bool isWhite);
 bool isBackwardPawn(const BoardState& state, int row, int col, bool isWhite);
+bool isBackwardPawnCandidate(const BoardState& state, int row, int col, bool isWhite);
 bool hasConnectedPawn(const BoardState& state, int row, int col, bool isWhite);
 
 #endif // PAWN_STRUCTURE_H
@@ -0,0 +1,36 @@
+#ifndef POLYGLOT_H
+#define POLYGLOT_H
+
+#include "types.h"
+#include <cstdint>
+
+// Polyglot opening book format
+// A book is a flat array of 16-byte big-endian entries sorted by key: the position's
+// Polyglot Zobrist key, a move, a weight (relative frequency) and a learn field that
+// is not used here. Keys use Polyglot's own random table, not the engine's Zobrist
+// keys, so books written by other tools can be read and ours by them.
+//
+// Moves pack to-file (bits 0-2), to-rank (3-5), from-file (6-8), from-rank (9-11) and
+// promotion (12-14: none, knight, bishop, rook, queen). Castling is encoded as the
+// king capturing its own rook (e1h1, e1a1, e8h8, e8a8).
+
+const int POLYGLOT_ENTRY_BYTES = 16;
+
+struct PolyglotEntry {
+    uint64_t key;
+    uint16_t move;
+    uint16_t weight;
+    uint32_t learn;
+};
+
+// Polyglot key: pieces, castling rights, the en passant file when a pawn can capture
+// there, and white to move
+uint64_t polyglotKey(const BoardState& state);
+
+uint16_t encodePolyglotMove(const Move& move);
+
+// Entries are big-endian on disk whatever the host byte order
+PolyglotEntry readPolyglotEntry(const unsigned char* bytes);
+void writePolyglotEntry(const PolyglotEntry& entry, unsigned char* bytes);
+
+#endif // POLYGLOT_H
@@ -0,0 +1,227 @@
+#include "profile.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+bool profilingEnabled = INSTRUMENTED_BUILD;
+
+static const char* const PHASE_NAMES[PROFILE_PHASE_COUNT] = {"search", "movegen", "ordering", "eval", "pawneval", "qsearch", "tt"};
+
+// Hardware events, opened as one group so they are read together
+enum { EVENT_CYCLES, EVENT_INSTRUCTIONS, EVENT_BRANCH_MISSES, EVENT_L1D_MISSES, EVENT_LLC_MISSES, EVENT_COUNT };
+static const char* const EVENT_NAMES[EVENT_COUNT] = {"cycles", "instructions", "branch-misses", "L1d-misses", "LLC-misses"};
+
+static const int MAX_PHASE_DEPTH = 512;
+
+struct PhaseTotals {
+    uint64_t nanoseconds;
+    uint64_t events[EVENT_COUNT];
+    uint64_t calls;
+};
+
+static PhaseTotals totals[PROFILE_PHASE_COUNT + 1]; // Last slot: outside any phase
+static int phaseStack[MAX_PHASE_DEPTH];
+static int phaseDepth = 0;
+static uint64_t lastNanoseconds = 0;
+static uint64_t lastEvents[EVENT_COUNT];
+
+static int groupFd = -1;
+static int eventSlot[EVENT_COUNT]; // Position in the group read, -1 if the event could not be opened
+static int openEvents = 0;
+#ifdef __linux__
+static perf_event_mmap_page* eventPage[EVENT_COUNT]; // Mapped for rdpmc, null if unused
+#endif
+static bool userReads = false; // Counters read with rdpmc instead of read()
+static bool profilerStarted = false;
+
+static uint64_t nowNanoseconds() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#ifdef __linux__
+static int openEvent(uint32_t type, uint64_t config, int leader) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = leader == -1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+}
+
+static uint64_t cacheMissConfig(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+// Map the event's control page so the counter can be read with rdpmc; false if the kernel
+// does not allow it (cap_user_rdpmc, /sys/bus/event_source/devices/cpu/rdpmc)
+static bool mapEvent(int event, int fd) {
+#if defined(__x86_64__) || defined(__i386__)
+    void* page = mmap(nullptr, (size_t)sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED, fd, 0);
+    if (page == MAP_FAILED) return false;
+    eventPage[event] = static_cast<perf_event_mmap_page*>(page);
+    return eventPage[event]->cap_user_rdpmc;
+#else
+    (void)event;
+    (void)fd;
+    return false;
+#endif
+}
+
+// Counter value through the control page; false if the event is not on a counter right now
+static bool readUserEvent(const perf_event_mmap_page* page, uint64_t& value) {
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t sequence;
+    do {
+        sequence = page->lock;
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        uint32_t index = page->index;
+        if (!page->cap_user_rdpmc || page->pmc_width == 0 || index == 0) return false;
+        uint32_t low, high;
+        asm volatile("rdpmc" : "=a"(low), "=d"(high) : "c"(index - 1));
+        // The hardware counter is pmc_width bits wide: sign-extend it before adding the offset
+        int shift = 64 - page->pmc_width;
+        int64_t count = (int64_t)(((uint64_t)high << 32 | low) << shift) >> shift;
+        value = page->offset + count;
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    } while (page->lock != sequence);
+    return true;
+#else
+    (void)page;
+    (void)value;
+    return false;
+#endif
+}
+#endif
+
+bool startProfiler() {
+    if (profilerStarted) return groupFd != -1;
+    profilerStarted = true;
+    for (int e = 0; e < EVENT_COUNT; ++e) eventSlot[e] = -1;
+#ifdef __linux__
+    const uint32_t types[EVENT_COUNT] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+                                         PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE};
+    const uint64_t configs[EVENT_COUNT] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES,
+                                           cacheMissConfig(PERF_COUNT_HW_CACHE_L1D), cacheMissConfig(PERF_COUNT_HW_CACHE_LL)};
+    groupFd = openEvent(types[0], configs[0], -1);
+    if (groupFd == -1) {
+        std::cerr << "Profiler: hardware counters unavailable (" << std::strerror(errno)
+                  << "), using wall-clock time only" << std::endl;
+        return false;
+    }
+    eventSlot[0] = openEvents++;
+    userReads = mapEvent(0, groupFd);
+    for (int e = 1; e < EVENT_COUNT; ++e) {
+        // Members the PMU does not support are left out of the group
+        int fd = openEvent(types[e], configs[e], groupFd);
+        if (fd == -1) continue;
+        eventSlot[e] = openEvents++;
+        userReads = mapEvent(e, fd) && userReads;
+    }
+    if (!userReads) std::cerr << "Profiler: rdpmc unavailable, reading counters with read()" << std::endl;
+    ioctl(groupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+#else
+    std::cerr << "Profiler: hardware counters need Linux, using wall-clock time only" << std::endl;
+    return false;
+#endif
+}
+
+// Current counter values; zeros without hardware counters
+static void readEvents(uint64_t* events) {
+    for (int e = 0; e < EVENT_COUNT; ++e) events[e] = 0;
+#ifdef __linux__
+    if (groupFd == -1) return;
+    if (userReads) {
+        // In user space without a system call; if any event is off its counter (multiplexed),
+        // the whole group is read with read() so that the values stay consistent
+        bool complete = true;
+        for (int e = 0; e < EVENT_COUNT && complete; ++e) {
+            if (eventSlot[e] >= 0) complete = readUserEvent(eventPage[e], events[e]);
+        }
+        if (complete) return;
+        for (int e = 0; e < EVENT_COUNT; ++e) events[e] = 0;
+    }
+    uint64_t buffer[1 + EVENT_COUNT];
+    if (read(groupFd, buffer, sizeof(buffer)) < (ssize_t)sizeof(uint64_t)) return;
+    for (int e = 0; e < EVENT_COUNT; ++e) {
+        if (eventSlot[e] >= 0 && (uint64_t)eventSlot[e] < buffer[0]) events[e] = buffer[1 + eventSlot[e]];
+    }
+#endif
+}
+
+// Charge everything since the last boundary to the innermost phase
+static void accountInterval() {
+    uint64_t now = nowNanoseconds();
+    uint64_t events[EVENT_COUNT];
+    readEvents(events);
+    PhaseTotals& current = totals[phaseDepth > 0 ? phaseStack[phaseDepth - 1] : PROFILE_PHASE_COUNT];
+    current.nanoseconds += now - lastNanoseconds;
+    for (int e = 0; e < EVENT_COUNT; ++e) current.events[e] += events[e] - lastEvents[e];
+    lastNanoseconds = now;
+    std::memcpy(lastEvents, events, sizeof(lastEvents));
+}
+
+void resetProfile() {
+    std::memset(totals, 0, sizeof(totals));
+    phaseDepth = 0;
+    lastNanoseconds = nowNanoseconds();
+    readEvents(lastEvents);
+}
+
+void profileEnter(ProfilePhase phase) {
+    accountInterval();
+    totals[phase].calls++;
+    if (phaseDepth < MAX_PHASE_DEPTH) phaseStack[phaseDepth] = phase;
+    phaseDepth++;
+}
+
+void profileLeave() {
+    accountInterval();
+    if (phaseDepth > 0) phaseDepth--;
+}
+
+void printProfile(const std::string& prefix) {
+    accountInterval();
+    uint64_t totalNanoseconds = 0, totalCycles = 0;
+    for (int p = 0; p < PROFILE_PHASE_COUNT; ++p) {
+        totalNanoseconds += totals[p].nanoseconds;
+        totalCycles += totals[p].events[EVENT_CYCLES];
+    }
+    for (int p = 0; p < PROFILE_PHASE_COUNT; ++p) {
+        const PhaseTotals& t = totals[p];
+        if (t.calls == 0) continue; // Including the phases only timed in instrumentation builds
+        std::ostringstream line;
+        line << prefix << "profile " << PHASE_NAMES[p] << " calls " << t.calls
+             << " time " << t.nanoseconds / 1000000 << " ms ("
+             << std::fixed << std::setprecision(1) << (totalNanoseconds ? 100.0 * t.nanoseconds / totalNanoseconds : 0.0) << "%)"
+             << " ns/call " << (t.calls ? t.nanoseconds / t.calls : 0);
+        if (groupFd != -1) {
+            for (int e = 0; e < EVENT_COUNT; ++e) {
+                if (eventSlot[e] >= 0) line << " " << EVENT_NAMES[e] << " " << t.events[e];
+            }
+            if (t.events[EVENT_CYCLES] > 0) {
+                line << " cycles% " << (totalCycles ? 100.0 * t.events[EVENT_CYCLES] / totalCycles : 0.0)
+                     << " ipc " << std::setprecision(2) << (double)t.events[EVENT_INSTRUCTIONS] / t.events[EVENT_CYCLES];
+            }
+        }
+        std::cout << line.str() << std::endl;
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <string>
+
+// Search phase profiling, enabled with `chess_engine --profile` (UCI, reported after every
+// go) or `chess_engine bench --profile`. Time and hardware counters (cycles, instructions,
+// branch misses, L1d and LLC read misses, opened with Linux perf_event_open and read with
+// rdpmc where the kernel allows it) are attributed to the innermost phase being executed,
+// so nested phases are excluded from their parent: "qsearch" is quiescence search minus its
+// move generation, evaluation and TT accesses.
+// Without PMU access (perf_event_paranoid, virtual machines) only wall-clock time is kept.
+//
+// Instrumentation builds (make clean && make INSTRUMENT=1) also time move ordering and pawn
+// evaluation, which are too fine-grained to check a flag on every call in normal builds, and
+// report the breakdown after every go without --profile.
+
+enum ProfilePhase {
+    PROFILE_SEARCH, PROFILE_MOVEGEN, PROFILE_ORDERING, PROFILE_EVAL, PROFILE_PAWN_EVAL,
+    PROFILE_QSEARCH, PROFILE_TT, PROFILE_PHASE_COUNT
+};
+
+#ifdef INSTRUMENT_TIMERS
+const bool INSTRUMENTED_BUILD = true;
+#else
+const bool INSTRUMENTED_BUILD = false;
+#endif
+
+extern bool profilingEnabled; // Starts out true in instrumentation builds
+
+// Open the hardware counters (once); reports on stderr and returns false if they are unavailable
+bool startProfiler();
+void resetProfile();
+
+void profileEnter(ProfilePhase phase);
+void profileLeave();
+
+// One line per phase (share of the time, calls, ns per call, counters), each starting
+// with 'prefix' ("info string " under UCI)
+void printProfile(const std::string& prefix);
+
+// Attributes the enclosing block to a phase when profiling is enabled
+struct ProfileScope {
+    explicit ProfileScope(ProfilePhase phase) : active(profilingEnabled) { if (active) profileEnter(phase); }
+    ~ProfileScope() { if (active) profileLeave(); }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+    bool active;
+};
+
+// Timer for the fine-grained phases: a ProfileScope in instrumentation builds, nothing otherwise
+#ifdef INSTRUMENT_TIMERS
+typedef ProfileScope TimerScope;
+#else
+struct TimerScope {
+    explicit TimerScope(ProfilePhase) {}
+};
+#endif
+
+#endif // PROFILE_H
@@ -1,17 +1,23 @@
 #include "search.h"
 #include "evaluation.h"
+#include "material.h"
+#include "bitbase.h"
 #include "movegen.h"
 #include "board.h"
+#include "attacks.h"
 #include "constants.h"
+#include "profile.h"
 #include <limits>
 #include <algorithm>
 #include <cstring>
+#include <cstdlib>
+#include <cctype>
 #include <vector>
 
 // Global search state
 std::atomic<bool> time_is_up{false};
 std::atomic<uint64_t> nodes_searched{0};
-std::map<std::string, TTEntry> transpositionTable;
+uint64_t node_limit = 0;
 
 // Killer moves: [ply][killer_index]
 Move killerMoves[64][2];
@@ -19,6 +25,18 @@ Move killerMoves[64][2];
 // History heuristic: [from_square][to_square]
 int historyTable[64][64];
 
+// Capture history: [moving_piece][to_square][captured_piece_type]
+int captureHistory[12][64][6];
+
+// Counter moves: [previous_moved_piece][previous_to_square]
+Move counterMoves[12][64];
+
+// Continuation history: [previous_piece][previous_to][piece][to]
+int continuationHistory[12][64][12][64];
+
+// Move played at each ply
+SearchStackEntry searchStack[64];
+
 // Clear killer moves
 void clearKillerMoves() {
     for (int ply = 0; ply < 64; ++ply) {
@@ -28,89 +46,210 @@ void clearKillerMoves() {
     }
 }
 
-// Clear history table
+// Clear history, capture history, counter-move and continuation tables (new game)
 void clearHistoryTable() {
     std::memset(historyTable, 0, sizeof(historyTable));
+    std::memset(captureHistory, 0, sizeof(captureHistory));
+    std::memset(continuationHistory, 0, sizeof(continuationHistory));
+    for (int p = 0; p < 12; ++p) {
+        for (int sq = 0; sq < 64; ++sq) counterMoves[p][sq] = Move();
+    }
 }
 
-// Quiescence search (unchanged - doesn't need ply tracking)
-int quiescenceSearch(BoardState state, int alpha, int beta, bool maximizingPlayer,
-                     const std::chrono::steady_clock::time_point& startTime,
-                     const std::chrono::milliseconds& timeLimit, int quiescenceDepth) {
-    if (time_is_up.load(std::memory_order_relaxed)) return 0;
-    nodes_searched++;
+// Decay history tables between searches so ordering knowledge carries over to the next move
+void ageHistoryTables() {
+    for (int* h = &historyTable[0][0]; h != &historyTable[0][0] + 64 * 64; ++h) *h /= 2;
+    for (int* h = &captureHistory[0][0][0]; h != &captureHistory[0][0][0] + 12 * 64 * 6; ++h) *h /= 2;
+    for (int* h = &continuationHistory[0][0][0][0]; h != &continuationHistory[0][0][0][0] + 12 * 64 * 12 * 64; ++h) *h /= 2;
+}
 
-    const uint64_t CHECK_TIME_MASK = 1023;
-    if ((nodes_searched.load(std::memory_order_relaxed) & CHECK_TIME_MASK) == 0) {
-        if (std::chrono::steady_clock::now() - startTime >= timeLimit) {
-            time_is_up.store(true, std::memory_order_relaxed);
-            return 0;
-        }
+// Gravity update: the entry saturates towards +/-HISTORY_MAX instead of growing without bound
+static void applyHistoryBonus(int& entry, int bonus) {
+    entry += bonus - entry * std::abs(bonus) / HISTORY_MAX;
+}
+
+// Update from/to history and the 1- and 2-ply continuation history of a quiet move
+static void updateQuietStats(const Move& move, int piece, int ply, int bonus) {
+    int toSquare = move.toRow * 8 + move.toCol;
+    applyHistoryBonus(historyTable[move.fromRow * 8 + move.fromCol][toSquare], bonus);
+    for (int back = 1; back <= 2; ++back) {
+        if (ply - back < 0) break;
+        const SearchStackEntry& prev = searchStack[ply - back];
+        if (prev.piece < 0) continue;
+        applyHistoryBonus(continuationHistory[prev.piece][prev.move.toRow * 8 + prev.move.toCol][piece][toSquare], bonus);
     }
-    if (quiescenceDepth <= 0) return evaluateBoard(state);
+}
 
-    int stand_pat = evaluateBoard(state);
-    bool in_check = isKingInCheck(state, state.whiteToMove);
+// Update capture history for a capture made from 'state'
+static void updateCaptureStats(const BoardState& state, const Move& move, int bonus) {
+    int piece = pieceIndex(state.board[move.fromRow][move.fromCol]);
+    int capturedType = move.isEnPassantCapture ? 0 : pieceIndex(state.board[move.toRow][move.toCol]) % PIECE_TYPE_COUNT;
+    applyHistoryBonus(captureHistory[piece][move.toRow * 8 + move.toCol][capturedType], bonus);
+}
 
-    if (in_check) {
-        if (maximizingPlayer) stand_pat -= IN_CHECK_PENALTY;
-        else stand_pat += IN_CHECK_PENALTY;
+// On a beta cutoff: reward the cutoff move, penalise the moves searched before it,
+// and record killer and counter moves for quiet cutoffs
+static void updateCutoffStats(const BoardState& state, const Move& best, int ply, int depth,
+                              const Move* quietsTried, int quietCount,
+                              const Move* capturesTried, int captureCount) {
+    int bonus = std::min(depth * depth, HISTORY_BONUS_MAX);
+    if (!best.isCapture(state) && best.promotionPiece == EMPTY) {
+        if (!(best == killerMoves[ply][0])) {
+            killerMoves[ply][1] = killerMoves[ply][0];
+            killerMoves[ply][0] = best;
+        }
+        if (ply >= 1 && searchStack[ply - 1].piece >= 0) {
+            const Move& prev = searchStack[ply - 1].move;
+            counterMoves[searchStack[ply - 1].piece][prev.toRow * 8 + prev.toCol] = best;
+        }
+        updateQuietStats(best, pieceIndex(state.board[best.fromRow][best.fromCol]), ply, bonus);
+        for (int i = 0; i < quietCount; ++i) {
+            updateQuietStats(quietsTried[i], pieceIndex(state.board[quietsTried[i].fromRow][quietsTried[i].fromCol]), ply, -bonus);
+        }
+    } else if (best.isCapture(state)) {
+        updateCaptureStats(state, best, bonus);
     }
+    for (int i = 0; i < captureCount; ++i) updateCaptureStats(state, capturesTried[i], -bonus);
+}
 
-    if (maximizingPlayer) {
-        if (stand_pat >= beta && !in_check) return beta;
-        alpha = std::max(alpha, stand_pat);
-    } else {
-        if (stand_pat <= alpha && !in_check) return alpha;
-        beta = std::min(beta, stand_pat);
+// Value a capture (or promotion) can win at most, for delta pruning
+static int captureGain(const BoardState& state, const Move& move) {
+    int gain = move.isEnPassantCapture ? piece_values[0] : 0;
+    char captured = state.board[move.toRow][move.toCol];
+    if (captured != EMPTY) gain = piece_values[pieceIndex(captured) % PIECE_TYPE_COUNT];
+    if (move.promotionPiece != EMPTY) gain += piece_values[pieceIndex(move.promotionPiece) % PIECE_TYPE_COUNT] - piece_values[0];
+    return gain;
+}
+
+// Search instances are specialised at compile time on the side being maximised and on the
+// node type, so the colour and PV tests below fold away. Scores are from white's perspective:
+// white's nodes maximise, black's minimise.
+//  - PV nodes have an open window. Their first move is searched with the full window, the
+//    rest with a null window and again with the full window if they land inside it.
+//  - Non-PV nodes have a null window (beta == alpha + 1) and may try a null move, except
+//    right after one (AllowNull).
+//  - The root is searched by searchRoot, whose moves lead to PV nodes.
+enum NodeType { NODE_PV, NODE_NON_PV };
+
+// Every 1024 nodes: stop the search once the time or node limit is reached
+static bool searchLimitReached(const std::chrono::steady_clock::time_point& startTime,
+                               const std::chrono::milliseconds& timeLimit) {
+    const uint64_t CHECK_TIME_MASK = 1023;
+    uint64_t nodes = nodes_searched.load(std::memory_order_relaxed);
+    if ((nodes & CHECK_TIME_MASK) != 0) return false;
+    if (std::chrono::steady_clock::now() - startTime >= timeLimit || (node_limit != 0 && nodes >= node_limit)) {
+        time_is_up.store(true, std::memory_order_relaxed);
+        return true;
     }
+    return false;
+}
 
-    std::vector<Move> q_moves;
-    generateLegalMoves(state, q_moves, !in_check);
-    orderMoves(state, q_moves, 0);
+// Quiescence search: captures from quiet positions, all evasions in check. Results are
+// kept in the transposition table at depth TT_DEPTH_QSEARCH.
+template <bool Maximizing>
+static int qsearch(const BoardState& state, int alpha, int beta,
+                   const std::chrono::steady_clock::time_point& startTime,
+                   const std::chrono::milliseconds& timeLimit, int quiescenceDepth) {
+    ProfileScope profileScope(PROFILE_QSEARCH);
+    if (time_is_up.load(std::memory_order_relaxed)) return 0;
+    nodes_searched++;
 
-    if (in_check && q_moves.empty()) {
-        return maximizingPlayer ? (-MATE_SCORE - MAX_SEARCH_PLY - quiescenceDepth) : (MATE_SCORE + MAX_SEARCH_PLY + quiescenceDepth);
+    if (searchLimitReached(startTime, timeLimit)) return 0;
+    // Stand pat only needs to be exact inside the window
+    if (quiescenceDepth <= 0) return cachedEvaluateBoard(state, alpha, beta);
+
+    TTEntry entry;
+    bool ttHit = transpositionTable.probe(state.hashKey, entry);
+    if (ttHit && entry.depth >= TT_DEPTH_QSEARCH) {
+        if (entry.flag == TT_EXACT) return entry.score;
+        if (entry.flag == TT_LOWERBOUND && entry.score >= beta) return entry.score;
+        if (entry.flag == TT_UPPERBOUND && entry.score <= alpha) return entry.score;
     }
-    if (!in_check && q_moves.empty()) {
-        return stand_pat;
+    // Entries from the main search are deeper: do not overwrite them
+    bool storeResult = !ttHit || entry.depth <= TT_DEPTH_QSEARCH;
+    const int alphaOrig = alpha, betaOrig = beta;
+
+    // Attack information shared by the evaluation and move generation
+    AttackInfo info;
+    {
+        ProfileScope movegenScope(PROFILE_MOVEGEN);
+        computeAttackInfo(state, info);
     }
+    bool in_check = info.checkers != 0;
 
-    if (maximizingPlayer) {
-        for (const auto& move : q_moves) {
-            BoardState nextState = state;
-            apply_raw_move_to_board(nextState, move);
-            int score = quiescenceSearch(nextState, alpha, beta, false, startTime, timeLimit, quiescenceDepth - 1);
-            if (time_is_up.load(std::memory_order_relaxed)) return 0;
-            alpha = std::max(alpha, score);
-            if (alpha >= beta) break;
+    MoveList q_moves;
+    int stand_pat = 0;
+    bool standPatExact = true;
+    if (in_check) {
+        // No standing pat in check: every evasion is searched
+        {
+            ProfileScope movegenScope(PROFILE_MOVEGEN);
+            generateEvasions(state, info, q_moves);
+        }
+        if (q_moves.empty()) {
+            return Maximizing ? (-MATE_SCORE - MAX_SEARCH_PLY - quiescenceDepth) : (MATE_SCORE + MAX_SEARCH_PLY + quiescenceDepth);
         }
-        return alpha;
     } else {
-        for (const auto& move : q_moves) {
-            BoardState nextState = state;
-            apply_raw_move_to_board(nextState, move);
-            int score = quiescenceSearch(nextState, alpha, beta, true, startTime, timeLimit, quiescenceDepth - 1);
-            if (time_is_up.load(std::memory_order_relaxed)) return 0;
-            beta = std::min(beta, score);
-            if (alpha >= beta) break;
+        stand_pat = cachedEvaluateBoard(state, alpha, beta, &info, &standPatExact);
+        if (Maximizing) {
+            if (stand_pat >= beta) {
+                if (storeResult) transpositionTable.store(state.hashKey, beta, TT_DEPTH_QSEARCH, TT_LOWERBOUND);
+                return beta;
+            }
+            alpha = std::max(alpha, stand_pat);
+        } else {
+            if (stand_pat <= alpha) {
+                if (storeResult) transpositionTable.store(state.hashKey, alpha, TT_DEPTH_QSEARCH, TT_UPPERBOUND);
+                return alpha;
+            }
+            beta = std::min(beta, stand_pat);
         }
-        return beta;
+        {
+            ProfileScope movegenScope(PROFILE_MOVEGEN);
+            generateLegalMoves(state, info, q_moves, true);
+        }
+        if (q_moves.empty()) return stand_pat;
+    }
+    orderMoves(state, q_moves, 0);
+
+    for (const auto& move : q_moves) {
+        // Delta pruning: even winning the captured piece cannot reach the window. A lazy
+        // stand pat is only a bound: the full evaluation may be up to LAZY_EVAL_MARGIN better.
+        if (!in_check) {
+            int bestCase = captureGain(state, move) + DELTA_PRUNING_MARGIN + (standPatExact ? 0 : LAZY_EVAL_MARGIN);
+            if (Maximizing ? stand_pat + bestCase <= alpha : stand_pat - bestCase >= beta) continue;
+        }
+        BoardState nextState = state;
+        apply_raw_move_to_board(nextState, move);
+        transpositionTable.prefetch(nextState.hashKey);
+        int score = qsearch<!Maximizing>(nextState, alpha, beta, startTime, timeLimit, quiescenceDepth - 1);
+        if (time_is_up.load(std::memory_order_relaxed)) return 0;
+        if (Maximizing) alpha = std::max(alpha, score);
+        else beta = std::min(beta, score);
+        if (alpha >= beta) break;
     }
+
+    int result = Maximizing ? alpha : beta;
+    if (storeResult) {
+        TTEntryFlag flag = result <= alphaOrig ? TT_UPPERBOUND : result >= betaOrig ? TT_LOWERBOUND : TT_EXACT;
+        transpositionTable.store(state.hashKey, result, TT_DEPTH_QSEARCH, flag);
+    }
+    return result;
 }
 
-// Alpha-beta search with null move pruning, killer moves, and history heuristic
-int alphaBetaSearch(BoardState state, int depth, int alpha, int beta, bool maximizingPlayer,
-                    const std::chrono::steady_clock::time_point& startTime,
-                    const std::chrono::milliseconds& timeLimit, int ply, bool allowNullMove)
+// Alpha-beta search with null move pruning, late move reductions, killer moves, and history heuristic
+template <NodeType NT, bool Maximizing, bool AllowNull = true>
+static int search(const BoardState& state, int depth, int alpha, int beta,
+                  const std::chrono::steady_clock::time_point& startTime,
+                  const std::chrono::milliseconds& timeLimit, int ply)
 {
+    const bool PvNode = NT == NODE_PV;
+    ProfileScope profileScope(PROFILE_SEARCH);
     if (time_is_up.load(std::memory_order_relaxed)) return 0;
     nodes_searched++;
 
-    std::string currentKey = state.currentFenKey;
-    auto tt_it = transpositionTable.find(currentKey);
-    if (tt_it != transpositionTable.end()) {
-        TTEntry& entry = tt_it->second;
+    TTEntry entry;
+    if (transpositionTable.probe(state.hashKey, entry)) {
         if (entry.depth >= depth) {
             if (entry.flag == TT_EXACT) return entry.score;
             if (entry.flag == TT_LOWERBOUND && entry.score >= beta) return entry.score;
@@ -118,191 +257,204 @@ int alphaBetaSearch(BoardState state, int depth, int alpha, int beta, bool maxim
         }
     }
 
-    std::vector<Move> legalMoves;
-    generateLegalMoves(state, legalMoves, false);
+    AttackInfo info;
+    MoveList legalMoves;
+    {
+        ProfileScope movegenScope(PROFILE_MOVEGEN);
+        computeAttackInfo(state, info);
+        generateLegalMoves(state, info, legalMoves, false);
+    }
+    bool inCheck = info.checkers != 0;
 
     if (legalMoves.empty()) {
-        if (isKingInCheck(state, state.whiteToMove)) return maximizingPlayer ? (-MATE_SCORE - depth) : (MATE_SCORE + depth);
+        if (inCheck) return Maximizing ? (-MATE_SCORE - depth) : (MATE_SCORE + depth);
         else return DRAW_SCORE;
     }
-    if (state.positionCounts[currentKey] >= 3 || state.halfmoveClock >= 100) return DRAW_SCORE;
+    if (repetitionCount(state.hashKey) >= 3 || state.halfmoveClock >= 100) return DRAW_SCORE;
 
-    if (depth == 0) {
-        return quiescenceSearch(state, alpha, beta, maximizingPlayer, startTime, timeLimit, MAX_QUIESCENCE_PLY);
-    }
+    // Neither side can force mate: no need to search further
+    if (probeMaterialTable(state).drawn) return DRAW_SCORE;
+    // Bitbase draws are exact; wins are left to the search so that it makes progress
+    if (probeBitbase(state) == BITBASE_DRAW) return DRAW_SCORE;
 
-    const uint64_t CHECK_TIME_MASK = 1023;
-    if ((nodes_searched.load(std::memory_order_relaxed) & CHECK_TIME_MASK) == 0) {
-        if (std::chrono::steady_clock::now() - startTime >= timeLimit) {
-            time_is_up.store(true, std::memory_order_relaxed);
-            return 0;
-        }
+    if (depth == 0) {
+        return qsearch<Maximizing>(state, alpha, beta, startTime, timeLimit, MAX_QUIESCENCE_PLY);
     }
 
-    bool inCheck = isKingInCheck(state, state.whiteToMove);
+    if (searchLimitReached(startTime, timeLimit)) return 0;
 
-    // Null Move Pruning
-    if (allowNullMove && !inCheck && depth >= NULL_MOVE_MIN_DEPTH) {
-        // Make null move (pass turn to opponent)
+    // Null Move Pruning: pass the turn and search the opponent's reply with a null window
+    // at the bound this node must reach; if passing is already good enough, cut off
+    if (!PvNode && AllowNull && !inCheck && depth >= NULL_MOVE_MIN_DEPTH) {
         BoardState nullState = state;
         nullState.whiteToMove = !nullState.whiteToMove;
-        nullState.updateFenKey();
-
-        int nullScore = -alphaBetaSearch(nullState, depth - 1 - NULL_MOVE_REDUCTION,
-                                         -beta, -beta + 1,
-                                         !maximizingPlayer,
-                                         startTime, timeLimit, ply + 1, false);
-
+        nullState.hashKey ^= zobristSide;
+        if (nullState.enPassantTarget.first != -1) {
+            nullState.hashKey ^= zobristEnPassant[nullState.enPassantTarget.second];
+            nullState.enPassantTarget = {-1, -1};
+        }
+        transpositionTable.prefetch(nullState.hashKey);
+        nullState.parentKey = state.hashKey;
+        nullState.dirtyCount = 0;
+        if (ply < MAX_SEARCH_PLY) searchStack[ply].piece = -1;
+
+        int nullAlpha = Maximizing ? beta - 1 : alpha;
+        int nullScore = search<NODE_NON_PV, !Maximizing, false>(nullState, depth - 1 - NULL_MOVE_REDUCTION,
+                                                                 nullAlpha, nullAlpha + 1, startTime, timeLimit, ply + 1);
         if (time_is_up.load(std::memory_order_relaxed)) return 0;
 
-        if (nullScore >= beta) {
-            return beta; // Beta cutoff from null move
+        if (Maximizing ? nullScore >= beta : nullScore <= alpha) {
+            return Maximizing ? beta : alpha; // Cutoff from null move
         }
     }
 
     orderMoves(state, legalMoves, ply);
-    TTEntryFlag bestFlag = TT_UPPERBOUND;
+    const int alphaOrig = alpha, betaOrig = beta;
+    int bestScore = Maximizing ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
     int movesSearchedCount = 0;
+    Move quietsTried[MAX_TRIED_MOVES]; int quietCount = 0;
+    Move capturesTried[MAX_TRIED_MOVES]; int captureCount = 0;
+
+    for (const auto& move : legalMoves) {
+        BoardState nextState = state;
+        apply_raw_move_to_board(nextState, move);
+        // The child probes its TT bucket first: start the likely cache miss now
+        transpositionTable.prefetch(nextState.hashKey);
+        if (ply < MAX_SEARCH_PLY) searchStack[ply] = {move, pieceIndex(state.board[move.fromRow][move.fromCol])};
+
+        int newDepth = depth - 1;
+        bool checksOpponent = givesCheck(state, info, move);
+        bool isCapture = move.isCapture(state);
+
+        // Check Extension
+        if (checksOpponent && depth < MAX_SEARCH_PLY) {
+            newDepth += CHECK_EXTENSION_PLY;
+        }
 
-    if (maximizingPlayer) {
-        int maxEval = std::numeric_limits<int>::min();
-        for (const auto& move : legalMoves) {
-            BoardState nextState = state;
-            apply_raw_move_to_board(nextState, move);
-
-            int currentEval;
-            int newDepth = depth - 1;
-            bool givesCheck = isKingInCheck(nextState, nextState.whiteToMove);
-
-            // Check Extension
-            if (givesCheck && depth < MAX_SEARCH_PLY) {
-                newDepth += CHECK_EXTENSION_PLY;
-            }
-
-            // Late Move Reduction (LMR)
-            bool applyLmr = false;
-            if (depth >= LMR_MIN_DEPTH_FOR_REDUCTION &&
-                movesSearchedCount >= LMR_MIN_MOVES_TO_TRY_REDUCTION &&
-                !move.isCapture(state) &&
-                move.promotionPiece == EMPTY &&
-                !inCheck &&
-                !givesCheck) {
-                applyLmr = true;
-            }
-
-            if (applyLmr) {
-                currentEval = alphaBetaSearch(nextState, newDepth - LMR_REDUCTION, alpha, beta, false, startTime, timeLimit, ply + 1, true);
-            } else {
-                currentEval = alphaBetaSearch(nextState, newDepth, alpha, beta, false, startTime, timeLimit, ply + 1, true);
-            }
-
-            if (time_is_up.load(std::memory_order_relaxed)) return 0;
+        // Late Move Reduction (LMR)
+        bool applyLmr = depth >= LMR_MIN_DEPTH_FOR_REDUCTION &&
+                        movesSearchedCount >= LMR_MIN_MOVES_TO_TRY_REDUCTION &&
+                        !isCapture &&
+                        move.promotionPiece == EMPTY &&
+                        !inCheck &&
+                        !checksOpponent;
+
+        int currentEval;
+        if (PvNode && movesSearchedCount == 0) {
+            currentEval = search<NODE_PV, !Maximizing>(nextState, newDepth, alpha, beta, startTime, timeLimit, ply + 1);
+        } else {
+            // Null window at the bound this node is trying to improve
+            int nullAlpha = Maximizing ? alpha : beta - 1;
+            currentEval = search<NODE_NON_PV, !Maximizing>(nextState, applyLmr ? newDepth - LMR_REDUCTION : newDepth,
+                                                            nullAlpha, nullAlpha + 1, startTime, timeLimit, ply + 1);
 
             // Re-search if LMR was applied and the score is promising
-            if (applyLmr && currentEval > alpha) {
-                 currentEval = alphaBetaSearch(nextState, newDepth, alpha, beta, false, startTime, timeLimit, ply + 1, true);
-                 if (time_is_up.load(std::memory_order_relaxed)) return 0;
+            if (applyLmr && (Maximizing ? currentEval > alpha : currentEval < beta) && !time_is_up.load(std::memory_order_relaxed)) {
+                currentEval = search<NODE_NON_PV, !Maximizing>(nextState, newDepth, nullAlpha, nullAlpha + 1,
+                                                                startTime, timeLimit, ply + 1);
             }
-
-            if (currentEval > maxEval) maxEval = currentEval;
-
-            if (currentEval > alpha) {
-                alpha = currentEval;
-                bestFlag = TT_EXACT;
-            }
-            if (beta <= alpha) {
-                bestFlag = TT_LOWERBOUND;
-
-                // Update killer moves for quiet moves
-                if (!move.isCapture(state) && move.promotionPiece == EMPTY && ply >= 0 && ply < MAX_SEARCH_PLY) {
-                    if (!(move == killerMoves[ply][0])) {
-                        killerMoves[ply][1] = killerMoves[ply][0];
-                        killerMoves[ply][0] = move;
-                    }
-
-                    // Update history table
-                    int fromSquare = move.fromRow * 8 + move.fromCol;
-                    int toSquare = move.toRow * 8 + move.toCol;
-                    historyTable[fromSquare][toSquare] += depth * depth;
-                }
-
-                break;
+            // Inside the window of a PV node: the exact score is needed
+            if (PvNode && currentEval > alpha && currentEval < beta && !time_is_up.load(std::memory_order_relaxed)) {
+                currentEval = search<NODE_PV, !Maximizing>(nextState, newDepth, alpha, beta, startTime, timeLimit, ply + 1);
             }
-            movesSearchedCount++;
-        }
-        if (!time_is_up.load(std::memory_order_relaxed) && (transpositionTable.size() < MAX_TT_SIZE || tt_it != transpositionTable.end())) {
-            TTEntry newEntry; newEntry.score = maxEval; newEntry.depth = depth; newEntry.flag = bestFlag;
-            transpositionTable[currentKey] = newEntry;
         }
-        return maxEval;
-    } else { // Minimizing Player
-        int minEval = std::numeric_limits<int>::max();
-        for (const auto& move : legalMoves) {
-            BoardState nextState = state; apply_raw_move_to_board(nextState, move);
-            int currentEval;
-            int newDepth = depth - 1;
-            bool givesCheck = isKingInCheck(nextState, nextState.whiteToMove);
-
-            // Check Extension
-            if (givesCheck && depth < MAX_SEARCH_PLY) {
-                newDepth += CHECK_EXTENSION_PLY;
-            }
 
-            // Late Move Reduction (LMR)
-            bool applyLmr = false;
-            if (depth >= LMR_MIN_DEPTH_FOR_REDUCTION &&
-                movesSearchedCount >= LMR_MIN_MOVES_TO_TRY_REDUCTION &&
-                !move.isCapture(state) &&
-                move.promotionPiece == EMPTY &&
-                !inCheck &&
-                !givesCheck) {
-                applyLmr = true;
-            }
+        if (time_is_up.load(std::memory_order_relaxed)) return 0;
 
-            if (applyLmr) {
-                 currentEval = alphaBetaSearch(nextState, newDepth - LMR_REDUCTION, alpha, beta, true, startTime, timeLimit, ply + 1, true);
-            } else {
-                 currentEval = alphaBetaSearch(nextState, newDepth, alpha, beta, true, startTime, timeLimit, ply + 1, true);
+        if (Maximizing) {
+            bestScore = std::max(bestScore, currentEval);
+            alpha = std::max(alpha, currentEval);
+        } else {
+            bestScore = std::min(bestScore, currentEval);
+            beta = std::min(beta, currentEval);
+        }
+        if (beta <= alpha) {
+            // Update killers, counter move and history tables
+            if (ply >= 0 && ply < MAX_SEARCH_PLY) {
+                updateCutoffStats(state, move, ply, depth, quietsTried, quietCount, capturesTried, captureCount);
             }
+            break;
+        }
+        if (isCapture) { if (captureCount < MAX_TRIED_MOVES) capturesTried[captureCount++] = move; }
+        else if (move.promotionPiece == EMPTY && quietCount < MAX_TRIED_MOVES) quietsTried[quietCount++] = move;
+        movesSearchedCount++;
+    }
 
-            if (time_is_up.load(std::memory_order_relaxed)) return 0;
-
-            // Re-search for LMR
-            if (applyLmr && currentEval < beta) {
-                 currentEval = alphaBetaSearch(nextState, newDepth, alpha, beta, true, startTime, timeLimit, ply + 1, true);
-                 if (time_is_up.load(std::memory_order_relaxed)) return 0;
-            }
+    TTEntryFlag flag = bestScore <= alphaOrig ? TT_UPPERBOUND : bestScore >= betaOrig ? TT_LOWERBOUND : TT_EXACT;
+    transpositionTable.store(state.hashKey, bestScore, depth, flag);
+    return bestScore;
+}
 
-            if (currentEval < minEval) minEval = currentEval;
+// Root moves are all searched with the same window, so moves sharing the best score can be
+// collected; a move scoring outside the aspiration window is searched again with the full window
+template <bool Maximizing>
+static int searchRoot(const BoardState& root, const MoveList& rootMoves, int depth, int previousScore,
+                      const std::chrono::steady_clock::time_point& startTime,
+                      const std::chrono::milliseconds& timeLimit, MoveList& bestMoves) {
+    // Aspiration window around the previous iteration's score, from white's perspective
+    int alpha = std::numeric_limits<int>::min();
+    int beta = std::numeric_limits<int>::max();
+    bool aspiration = depth >= ASPIRATION_MIN_DEPTH && previousScore != std::numeric_limits<int>::min();
+    if (aspiration) {
+        int center = Maximizing ? previousScore : -previousScore;
+        alpha = center - ASPIRATION_WINDOW;
+        beta = center + ASPIRATION_WINDOW;
+    }
 
-            if (currentEval < beta) {
-                beta = currentEval;
-                bestFlag = TT_EXACT;
-            }
-            if (beta <= alpha) {
-                bestFlag = TT_UPPERBOUND;
-
-                // Update killer moves for quiet moves
-                if (!move.isCapture(state) && move.promotionPiece == EMPTY && ply >= 0 && ply < MAX_SEARCH_PLY) {
-                    if (!(move == killerMoves[ply][0])) {
-                        killerMoves[ply][1] = killerMoves[ply][0];
-                        killerMoves[ply][0] = move;
-                    }
-
-                    // Update history table
-                    int fromSquare = move.fromRow * 8 + move.fromCol;
-                    int toSquare = move.toRow * 8 + move.toCol;
-                    historyTable[fromSquare][toSquare] += depth * depth;
-                }
-
-                break;
-            }
-            movesSearchedCount++;
+    int bestScore = std::numeric_limits<int>::min();
+    bestMoves.clear();
+    for (const auto& move : rootMoves) {
+        BoardState nextState = root;
+        apply_raw_move_to_board(nextState, move);
+        searchStack[0] = {move, pieceIndex(root.board[move.fromRow][move.fromCol])};
+        int score = search<NODE_PV, !Maximizing>(nextState, depth - 1, alpha, beta, startTime, timeLimit, 1);
+        if (time_is_up.load(std::memory_order_relaxed)) break;
+
+        if (aspiration && (score <= alpha || score >= beta)) {
+            score = search<NODE_PV, !Maximizing>(nextState, depth - 1, std::numeric_limits<int>::min(),
+                                                 std::numeric_limits<int>::max(), startTime, timeLimit, 1);
+            if (time_is_up.load(std::memory_order_relaxed)) break;
         }
-        if (!time_is_up.load(std::memory_order_relaxed) && (transpositionTable.size() < MAX_TT_SIZE || tt_it != transpositionTable.end())) {
-            TTEntry newEntry; newEntry.score = minEval; newEntry.depth = depth; newEntry.flag = bestFlag;
-            transpositionTable[currentKey] = newEntry;
+
+        // From the side to move's perspective
+        if (!Maximizing) score = -score;
+        if (score > bestScore) {
+            bestScore = score;
+            bestMoves.clear();
+            bestMoves.push_back(move);
+        } else if (score == bestScore) {
+            bestMoves.push_back(move);
         }
-        return minEval;
     }
+    return bestScore;
+}
+
+int searchRoot(const BoardState& root, const MoveList& rootMoves, int depth, int previousScore,
+               const std::chrono::steady_clock::time_point& startTime,
+               const std::chrono::milliseconds& timeLimit, MoveList& bestMoves) {
+    if (root.whiteToMove) return searchRoot<true>(root, rootMoves, depth, previousScore, startTime, timeLimit, bestMoves);
+    return searchRoot<false>(root, rootMoves, depth, previousScore, startTime, timeLimit, bestMoves);
+}
+
+int alphaBetaSearch(const BoardState& state, int depth, int alpha, int beta, bool maximizingPlayer,
+                    const std::chrono::steady_clock::time_point& startTime,
+                    const std::chrono::milliseconds& timeLimit, int ply, bool allowNullMove) {
+    // An open window is a PV node; null windows are non-PV nodes
+    if (beta > alpha + 1) {
+        return maximizingPlayer ? search<NODE_PV, true>(state, depth, alpha, beta, startTime, timeLimit, ply)
+                                : search<NODE_PV, false>(state, depth, alpha, beta, startTime, timeLimit, ply);
+    }
+    if (allowNullMove) {
+        return maximizingPlayer ? search<NODE_NON_PV, true>(state, depth, alpha, beta, startTime, timeLimit, ply)
+                                : search<NODE_NON_PV, false>(state, depth, alpha, beta, startTime, timeLimit, ply);
+    }
+    return maximizingPlayer ? search<NODE_NON_PV, true, false>(state, depth, alpha, beta, startTime, timeLimit, ply)
+                            : search<NODE_NON_PV, false, false>(state, depth, alpha, beta, startTime, timeLimit, ply);
+}
+
+int quiescenceSearch(const BoardState& state, int alpha, int beta, bool maximizingPlayer,
+                     const std::chrono::steady_clock::time_point& startTime,
+                     const std::chrono::milliseconds& timeLimit, int quiescenceDepth) {
+    return maximizingPlayer ? qsearch<true>(state, alpha, beta, startTime, timeLimit, quiescenceDepth)
+                            : qsearch<false>(state, alpha, beta, startTime, timeLimit, quiescenceDepth);
 }
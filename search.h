@@ -2,6 +2,7 @@
 #define SEARCH_H
 
 #include "types.h"
+#include "tt.h"
 #include <chrono>
 #include <atomic>
 #include <map>
@@ -10,7 +11,7 @@
 // Global search state
 extern std::atomic<bool> time_is_up;
 extern std::atomic<uint64_t> nodes_searched;
-extern std::map<std::string, TTEntry> transpositionTable;
+extern uint64_t node_limit; // Stop after this many nodes (go nodes), 0 for none
 
 // Killer moves: [ply][killer_index]
 extern Move killerMoves[64][2];
@@ -18,16 +19,42 @@ extern Move killerMoves[64][2];
 // History heuristic: [from_square][to_square]
 extern int historyTable[64][64];
 
+// Capture history: [moving_piece][to_square][captured_piece_type]
+extern int captureHistory[12][64][6];
+
+// Counter moves: [previous_moved_piece][previous_to_square]
+extern Move counterMoves[12][64];
+
+// Continuation history: [previous_piece][previous_to][piece][to], used for 1 and 2 plies back
+extern int continuationHistory[12][64][12][64];
+
+// Move played at each ply (ply 0 = root move), for counter-move and continuation history
+struct SearchStackEntry {
+    Move move;
+    int piece; // pieceIndex of the moved piece, -1 for a null move
+};
+extern SearchStackEntry searchStack[64];
+
 // Helper functions
 void clearKillerMoves();
 void clearHistoryTable();
-
-// Search functions
-int alphaBetaSearch(BoardState state, int depth, int alpha, int beta, bool maximizingPlayer,
+void ageHistoryTables();
+
+// Search functions. Scores are from white's perspective; the side to move maximises if white.
+// Search one iteration at the root: every root move is searched at 'depth' and the moves
+// sharing the best score are returned in bestMoves. previousScore is the last iteration's
+// best score (side to move's perspective) for the aspiration window, INT_MIN for none.
+// Returns the best score from the side to move's perspective.
+int searchRoot(const BoardState& root, const MoveList& rootMoves, int depth, int previousScore,
+               const std::chrono::steady_clock::time_point& startTime,
+               const std::chrono::milliseconds& timeLimit, MoveList& bestMoves);
+
+// Search a position below the root; open windows are searched as PV nodes
+int alphaBetaSearch(const BoardState& state, int depth, int alpha, int beta, bool maximizingPlayer,
                     const std::chrono::steady_clock::time_point& startTime,
                     const std::chrono::milliseconds& timeLimit, int ply, bool allowNullMove);
 
-int quiescenceSearch(BoardState state, int alpha, int beta, bool maximizingPlayer,
+int quiescenceSearch(const BoardState& state, int alpha, int beta, bool maximizingPlayer,
                      const std::chrono::steady_clock::time_point& startTime,
                      const std::chrono::milliseconds& timeLimit, int quiescenceDepth);
 
@@ -0,0 +1,429 @@
+#include "tt.h"
+#include "board.h"
+#include "profile.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+
+// Global transposition table instance
+TranspositionTable transpositionTable;
+
+// Packed slot data
+static uint64_t packData(int score, int depth, TTEntryFlag flag, uint8_t generation) {
+    return (uint64_t)(uint32_t)score | ((uint64_t)(uint16_t)(int16_t)depth << 32) |
+           ((uint64_t)(flag + 1) << 48) | ((uint64_t)generation << 56);
+}
+static int dataScore(uint64_t data) { return (int32_t)(uint32_t)data; }
+static int dataDepth(uint64_t data) { return (int16_t)(uint16_t)(data >> 32); }
+static int dataFlag(uint64_t data) { return (int)((data >> 48) & 0xFF) - 1; } // -1: empty slot
+static uint8_t dataGeneration(uint64_t data) { return (uint8_t)(data >> 56); }
+
+static uint64_t zobristCheckValue();
+
+TranspositionTable::TranspositionTable()
+    : buckets(nullptr), bucketCount(0), mappedBytes(0), mapping(nullptr), localGeneration(0), sharedHeader(nullptr), sharedInode(0),
+      largePagesAllowed(true), pageMode(TT_PAGES_NORMAL) {
+    resize(DEFAULT_TT_SIZE_MB);
+}
+
+TranspositionTable::~TranspositionTable() { release(); }
+
+// Take the lock that serialises attaching to and removing the shared segment 'name'. It is an
+// flock on a side file, so it is dropped if the holder dies. Returns the descriptor, or -1.
+static int lockSharedName(const std::string& name) {
+    std::string path = std::string(TT_SHARED_LOCK_DIR) + name + ".lock";
+    int fd = open(path.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+        std::cerr << "Warning: Could not open " << path << ": " << std::strerror(errno) << std::endl;
+        return -1;
+    }
+    int waitedMs = 0;
+    while (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        if (errno != EWOULDBLOCK || waitedMs >= TT_SHARED_ATTACH_TIMEOUT_MS) {
+            std::cerr << "Warning: Could not lock " << path << std::endl;
+            close(fd);
+            return -1;
+        }
+        usleep(1000);
+        waitedMs++;
+    }
+    return fd;
+}
+
+static void unlockSharedName(int fd) {
+    if (fd < 0) return;
+    flock(fd, LOCK_UN);
+    close(fd);
+}
+
+// Remove the name 'name' if it still refers to the segment with inode 'inode'
+static void unlinkSharedSegment(const std::string& name, uint64_t inode) {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) return;
+    struct stat st;
+    bool same = fstat(fd, &st) == 0 && (uint64_t)st.st_ino == inode;
+    close(fd);
+    if (same) shm_unlink(name.c_str());
+}
+
+// Unmap the current table; the last process leaving a shared table removes its segment
+void TranspositionTable::release() {
+    if (sharedHeader) {
+        int lockFd = lockSharedName(sharedName);
+        if (sharedHeader->attachCount.fetch_sub(1) == 1 && lockFd >= 0) unlinkSharedSegment(sharedName, sharedInode);
+        unlockSharedName(lockFd);
+        sharedHeader = nullptr;
+    }
+    if (mapping) munmap(mapping, mappedBytes);
+    mapping = nullptr;
+    buckets = nullptr;
+    bucketCount = 0;
+    mappedBytes = 0;
+    pageMode = TT_PAGES_NORMAL;
+}
+
+// Whether the kernel honours MADV_HUGEPAGE ("always" or "madvise" transparent huge pages)
+static bool transparentHugePagesEnabled() {
+    int fd = open("/sys/kernel/mm/transparent_hugepage/enabled", O_RDONLY);
+    if (fd < 0) return false;
+    char text[128];
+    ssize_t length = read(fd, text, sizeof(text) - 1);
+    close(fd);
+    if (length <= 0) return false;
+    text[length] = '\0';
+    return std::strstr(text, "[never]") == nullptr;
+}
+
+void TranspositionTable::resize(size_t megabytes) {
+    size_t bytes = megabytes * 1024 * 1024;
+    size_t count = 1;
+    while (count * 2 * sizeof(TTBucket) <= bytes) count *= 2;
+    release();
+    // Anonymous mappings are zero-filled, which is the empty slot encoding
+    size_t tableBytes = count * sizeof(TTBucket);
+    bool largePages = largePagesAllowed && tableBytes >= TT_LARGE_PAGE_BYTES;
+    void* map = MAP_FAILED;
+    char* table = nullptr;
+#ifdef MAP_HUGETLB
+    // The table size is a power of two, so a multiple of the huge page size here
+    if (largePages) map = mmap(nullptr, tableBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (map != MAP_FAILED) {
+        mappedBytes = tableBytes;
+        table = static_cast<char*>(map);
+        pageMode = TT_PAGES_HUGETLB;
+    }
+#endif
+    if (map == MAP_FAILED) {
+        // Transparent huge pages only back 2 MB aligned ranges: over-allocate and align the table
+        mappedBytes = tableBytes + (largePages ? TT_LARGE_PAGE_BYTES : 0);
+        map = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map == MAP_FAILED) {
+            std::cerr << "Error: Could not allocate " << megabytes << " MB transposition table" << std::endl;
+            std::exit(1);
+        }
+        table = static_cast<char*>(map);
+        if (largePages) {
+            table += (TT_LARGE_PAGE_BYTES - (uintptr_t)table % TT_LARGE_PAGE_BYTES) % TT_LARGE_PAGE_BYTES;
+#ifdef MADV_HUGEPAGE
+            if (madvise(table, tableBytes, MADV_HUGEPAGE) == 0 && transparentHugePagesEnabled()) pageMode = TT_PAGES_TRANSPARENT;
+#endif
+        }
+    }
+    mapping = map;
+    buckets = reinterpret_cast<TTBucket*>(table);
+    bucketCount = count;
+    localGeneration = 0;
+}
+
+void TranspositionTable::setLargePages(bool allowed) {
+    if (allowed == largePagesAllowed) return;
+    largePagesAllowed = allowed;
+    if (!sharedHeader) resize(sizeMB());
+}
+
+void TranspositionTable::clear() {
+    for (size_t b = 0; b < bucketCount; ++b) {
+        for (int i = 0; i < TT_BUCKET_SIZE; ++i) {
+            buckets[b].slots[i].data.store(0, std::memory_order_relaxed);
+            buckets[b].slots[i].check.store(0, std::memory_order_relaxed);
+        }
+    }
+    localGeneration = 0;
+}
+
+void TranspositionTable::newSearch() {
+    if (sharedHeader) sharedHeader->generation.fetch_add(1, std::memory_order_relaxed);
+    else localGeneration++;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& entry) const {
+    ProfileScope profileScope(PROFILE_TT);
+    const TTBucket& bucket = bucketFor(key);
+    for (int i = 0; i < TT_BUCKET_SIZE; ++i) {
+        uint64_t data = bucket.slots[i].data.load(std::memory_order_relaxed);
+        uint64_t check = bucket.slots[i].check.load(std::memory_order_relaxed);
+        if ((check ^ data) == key && dataFlag(data) >= 0) {
+            entry.key = key;
+            entry.score = dataScore(data);
+            entry.depth = (int16_t)dataDepth(data);
+            entry.flag = (uint8_t)dataFlag(data);
+            entry.generation = dataGeneration(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, int score, int depth, TTEntryFlag flag) {
+    ProfileScope profileScope(PROFILE_TT);
+    TTBucket& bucket = bucketFor(key);
+    uint8_t currentGeneration = generation();
+    TTSlot* replace = &bucket.slots[0];
+    int worstValue = 1 << 30;
+    for (int i = 0; i < TT_BUCKET_SIZE; ++i) {
+        TTSlot& slot = bucket.slots[i];
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        uint64_t check = slot.check.load(std::memory_order_relaxed);
+        // Same position or empty slot: use it directly
+        if ((check ^ data) == key || dataFlag(data) < 0) { replace = &slot; break; }
+        // Otherwise prefer entries from older searches, then shallower ones
+        int age = (uint8_t)(currentGeneration - dataGeneration(data));
+        int value = dataDepth(data) - TT_AGE_WEIGHT * age;
+        if (value < worstValue) { worstValue = value; replace = &slot; }
+    }
+    uint64_t data = packData(score, depth, flag, currentGeneration);
+    replace->data.store(data, std::memory_order_relaxed);
+    replace->check.store(key ^ data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const {
+    int used = 0;
+    uint8_t currentGeneration = generation();
+    size_t sampleBuckets = std::min<size_t>(bucketCount, 1000 / TT_BUCKET_SIZE);
+    for (size_t b = 0; b < sampleBuckets; ++b) {
+        for (int i = 0; i < TT_BUCKET_SIZE; ++i) {
+            uint64_t data = buckets[b].slots[i].data.load(std::memory_order_relaxed);
+            if (dataFlag(data) >= 0 && dataGeneration(data) == currentGeneration) used++;
+        }
+    }
+    return sampleBuckets ? used * 1000 / (int)(sampleBuckets * TT_BUCKET_SIZE) : 0;
+}
+
+bool TranspositionTable::attachShared(const std::string& name, size_t megabytes) {
+    size_t count = 1;
+    while (count * 2 * sizeof(TTBucket) <= megabytes * 1024 * 1024) count *= 2;
+
+    // Attaching and removing the name are serialised, so a segment cannot be unlinked between
+    // being opened here and being counted, and a creator always finishes its header before
+    // anyone else maps it. A segment that is not ready under the lock was left behind by a
+    // creator that died, and is replaced.
+    int lockFd = lockSharedName(name);
+    if (lockFd < 0) return false;
+
+    void* map = nullptr;
+    size_t bytes = 0;
+    SharedTTHeader* header = nullptr;
+    struct stat st;
+    for (int attempt = 0; attempt < 2 && !header; ++attempt) {
+        // The creator is whoever wins O_EXCL; everyone else adopts its header
+        bool creator = true;
+        int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0 && errno == EEXIST) {
+            creator = false;
+            fd = shm_open(name.c_str(), O_RDWR, 0600);
+        }
+        if (fd < 0) {
+            std::cerr << "Warning: Could not open shared hash " << name << ": " << std::strerror(errno) << std::endl;
+            break;
+        }
+        if (fstat(fd, &st) != 0) {
+            std::cerr << "Warning: Could not stat shared hash " << name << std::endl;
+            close(fd);
+            break;
+        }
+
+        if (creator) {
+            bytes = TT_SHARED_HEADER_BYTES + count * sizeof(TTBucket);
+            if (ftruncate(fd, (off_t)bytes) != 0) {
+                std::cerr << "Warning: Could not size shared hash " << name << std::endl;
+                close(fd);
+                shm_unlink(name.c_str());
+                break;
+            }
+        } else if ((size_t)st.st_size < TT_SHARED_HEADER_BYTES) {
+            std::cerr << "Warning: Shared hash " << name << " was never initialized, recreating it" << std::endl;
+            close(fd);
+            shm_unlink(name.c_str());
+            continue;
+        } else {
+            bytes = (size_t)st.st_size;
+        }
+
+        map = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+            std::cerr << "Warning: Could not map shared hash " << name << std::endl;
+            if (creator) shm_unlink(name.c_str());
+            break;
+        }
+        SharedTTHeader* mapped = static_cast<SharedTTHeader*>(map);
+        // Count ourselves before validating; rolled back below on failure
+        mapped->attachCount.fetch_add(1);
+
+        if (creator) {
+            // The segment is zero-filled, so the attach count and generation start at 0
+            std::memcpy(mapped->magic, TT_FILE_MAGIC, sizeof(mapped->magic));
+            mapped->version = TT_FILE_VERSION;
+            mapped->bucketCount = count;
+            mapped->zobristCheck = zobristCheckValue();
+            mapped->ready.store(1, std::memory_order_release);
+            header = mapped;
+            break;
+        }
+
+        if (mapped->ready.load(std::memory_order_acquire) == 0) {
+            std::cerr << "Warning: Shared hash " << name << " was never initialized, recreating it" << std::endl;
+            mapped->attachCount.fetch_sub(1);
+            munmap(map, bytes);
+            shm_unlink(name.c_str());
+            continue;
+        }
+        const char* problem = nullptr;
+        if (std::memcmp(mapped->magic, TT_FILE_MAGIC, sizeof(mapped->magic)) != 0 || mapped->version != TT_FILE_VERSION) problem = "different format";
+        else if (mapped->zobristCheck != zobristCheckValue()) problem = "different Zobrist keys";
+        else if (bytes != TT_SHARED_HEADER_BYTES + mapped->bucketCount * sizeof(TTBucket)) problem = "bad table size";
+        if (problem) {
+            std::cerr << "Warning: Incompatible shared hash " << name << " (" << problem << ")" << std::endl;
+            mapped->attachCount.fetch_sub(1);
+            munmap(map, bytes);
+            break;
+        }
+        header = mapped;
+    }
+    unlockSharedName(lockFd);
+    if (!header) return false;
+
+    // Our count on the new segment keeps it alive while the previous table is released
+    release();
+    mapping = map;
+    mappedBytes = bytes;
+    sharedHeader = header;
+    sharedName = name;
+    sharedInode = (uint64_t)st.st_ino;
+    buckets = reinterpret_cast<TTBucket*>(static_cast<char*>(map) + TT_SHARED_HEADER_BYTES);
+    bucketCount = header->bucketCount;
+    return true;
+}
+
+void TranspositionTable::detachShared(size_t megabytes) {
+    if (!sharedHeader) return;
+    resize(megabytes);
+}
+
+// Start position key, stored in hash files to detect incompatible Zobrist keys
+static uint64_t zobristCheckValue() {
+    BoardState startpos;
+    return startpos.hashKey;
+}
+
+bool TranspositionTable::saveToFile(const std::string& path) const {
+    TTFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, TT_FILE_MAGIC, sizeof(header.magic));
+    header.version = TT_FILE_VERSION;
+    header.byteOrder = TT_FILE_BYTE_ORDER;
+    header.entrySize = sizeof(TTSlot);
+    header.bucketSize = TT_BUCKET_SIZE;
+    header.bucketCount = bucketCount;
+    header.zobristCheck = zobristCheckValue();
+    header.generation = generation();
+
+    size_t dataBytes = bucketCount * sizeof(TTBucket);
+    size_t fileBytes = sizeof(header) + dataBytes;
+
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Warning: Could not create hash file: " << path << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, (off_t)fileBytes) != 0) {
+        std::cerr << "Warning: Could not size hash file: " << path << std::endl;
+        close(fd);
+        return false;
+    }
+    void* map = mmap(nullptr, fileBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << "Warning: Could not map hash file: " << path << std::endl;
+        return false;
+    }
+    std::memcpy(map, &header, sizeof(header));
+    std::memcpy(static_cast<char*>(map) + sizeof(header), static_cast<const void*>(buckets), dataBytes);
+    bool ok = msync(map, fileBytes, MS_SYNC) == 0;
+    munmap(map, fileBytes);
+    if (!ok) std::cerr << "Warning: Could not write hash file: " << path << std::endl;
+    return ok;
+}
+
+bool TranspositionTable::loadFromFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Warning: Could not open hash file: " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TTFileHeader)) {
+        std::cerr << "Warning: Hash file too small: " << path << std::endl;
+        close(fd);
+        return false;
+    }
+    size_t fileBytes = (size_t)st.st_size;
+    void* map = mmap(nullptr, fileBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << "Warning: Could not map hash file: " << path << std::endl;
+        return false;
+    }
+
+    TTFileHeader header;
+    std::memcpy(&header, map, sizeof(header));
+    const char* problem = nullptr;
+    if (std::memcmp(header.magic, TT_FILE_MAGIC, sizeof(header.magic)) != 0) problem = "not a hash file";
+    else if (header.version != TT_FILE_VERSION) problem = "unsupported version";
+    else if (header.byteOrder != TT_FILE_BYTE_ORDER) problem = "different byte order";
+    else if (header.entrySize != sizeof(TTSlot) || header.bucketSize != TT_BUCKET_SIZE) problem = "different entry layout";
+    else if (header.zobristCheck != zobristCheckValue()) problem = "different Zobrist keys";
+    // Only sizes the Hash option can produce (1 MB to MAX_TT_SIZE_MB); checked before multiplying
+    else if (header.bucketCount < 1024 * 1024 / sizeof(TTBucket) ||
+             header.bucketCount > MAX_TT_SIZE_MB * 1024 * 1024 / sizeof(TTBucket) ||
+             (header.bucketCount & (header.bucketCount - 1)) != 0 ||
+             fileBytes != sizeof(header) + header.bucketCount * sizeof(TTBucket)) problem = "bad table size";
+    else if (sharedHeader && header.bucketCount != bucketCount) problem = "size differs from the shared table";
+
+    if (problem) {
+        std::cerr << "Warning: Incompatible hash file (" << problem << "): " << path << std::endl;
+        munmap(map, fileBytes);
+        return false;
+    }
+
+    if (!sharedHeader && header.bucketCount != bucketCount) {
+        resize(header.bucketCount * sizeof(TTBucket) / (1024 * 1024));
+        if (bucketCount != header.bucketCount) {
+            std::cerr << "Warning: Incompatible hash file (table size not reproducible): " << path << std::endl;
+            munmap(map, fileBytes);
+            return false;
+        }
+    }
+    std::memcpy(static_cast<void*>(buckets), static_cast<const char*>(map) + sizeof(header), header.bucketCount * sizeof(TTBucket));
+    if (sharedHeader) sharedHeader->generation.store(header.generation);
+    else localGeneration = header.generation;
+    munmap(map, fileBytes);
+    return true;
+}
@@ -0,0 +1,134 @@
+#ifndef TT_H
+#define TT_H
+
+#include "constants.h"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Transposition Table
+// Fixed-size table of 4-entry buckets indexed by Zobrist key. It is kept between
+// moves of a game; each search bumps the generation so that entries left over
+// from earlier searches are the first to be replaced.
+//
+// Entries are stored lock-free as two 64-bit words: the packed data and the key
+// XORed with that data. A reader only accepts a slot whose words XOR back to its
+// key, so a slot torn by a concurrent writer reads as a miss instead of a wrong
+// hit. This makes the table safe to share between threads or, with the
+// "Shared Hash" option, between processes through POSIX shared memory.
+//
+// Private tables of at least TT_LARGE_PAGE_BYTES are backed by huge pages when the
+// system allows it, to cut TLB misses on multi-GB tables: explicit hugetlbfs pages
+// (MAP_HUGETLB, needs vm.nr_hugepages) first, then 2 MB aligned memory advised with
+// MADV_HUGEPAGE for transparent huge pages, then ordinary pages.
+
+// Pages backing the table
+enum TTPageMode { TT_PAGES_NORMAL, TT_PAGES_TRANSPARENT, TT_PAGES_HUGETLB };
+
+struct TTSlot {
+    std::atomic<uint64_t> check; // key ^ data
+    std::atomic<uint64_t> data;  // score | depth << 32 | (flag + 1) << 48 | generation << 56
+};
+
+struct alignas(64) TTBucket {
+    TTSlot slots[TT_BUCKET_SIZE];
+};
+
+static_assert(sizeof(TTSlot) == 16, "TTSlot must stay packed for the hash file format");
+
+// Header of a saved hash file (savehash / loadhash). The raw bucket array follows it.
+struct TTFileHeader {
+    char magic[8];          // TT_FILE_MAGIC
+    uint32_t version;       // TT_FILE_VERSION
+    uint32_t byteOrder;     // TT_FILE_BYTE_ORDER as written by the saving machine
+    uint32_t entrySize;     // sizeof(TTSlot)
+    uint32_t bucketSize;    // TT_BUCKET_SIZE
+    uint64_t bucketCount;
+    uint64_t zobristCheck;  // Key of the start position: rejects files from different Zobrist keys
+    uint8_t generation;
+    uint8_t padding[7];
+};
+
+// Header at the start of a shared-memory table; the bucket array starts TT_SHARED_HEADER_BYTES in
+struct SharedTTHeader {
+    char magic[8];                    // TT_FILE_MAGIC
+    uint32_t version;                 // TT_FILE_VERSION
+    std::atomic<uint32_t> ready;      // Set by the creating process once the header is valid
+    uint64_t bucketCount;
+    uint64_t zobristCheck;
+    std::atomic<uint32_t> attachCount; // Processes currently attached
+    std::atomic<uint8_t> generation;   // Shared search generation
+};
+
+class TranspositionTable {
+private:
+    TTBucket* buckets;
+    size_t bucketCount;
+    size_t mappedBytes;          // Size of the current mapping (private or shared)
+    void* mapping;
+    uint8_t localGeneration;
+    SharedTTHeader* sharedHeader; // Non-null while attached to a shared segment
+    std::string sharedName;
+    uint64_t sharedInode;        // Inode of our segment: the name may since refer to a newer one
+    bool largePagesAllowed;
+    TTPageMode pageMode;
+
+    TTBucket& bucketFor(uint64_t key) const { return buckets[key & (bucketCount - 1)]; }
+    uint8_t generation() const { return sharedHeader ? sharedHeader->generation.load(std::memory_order_relaxed) : localGeneration; }
+    void release();
+
+public:
+    TranspositionTable();
+    ~TranspositionTable();
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Resize to the largest power-of-two bucket count fitting in 'megabytes' (clears the table).
+    // Detaches from a shared segment first.
+    void resize(size_t megabytes);
+
+    // Remove all entries (Clear Hash, or ucinewgame on a private table); clears a shared table
+    // for every process
+    void clear();
+
+    // Start a new search generation
+    void newSearch();
+
+    // Start loading the bucket of 'key' into the cache, ahead of a probe of that position
+    void prefetch(uint64_t key) const { __builtin_prefetch(&bucketFor(key)); }
+
+    // Look up a position; returns true and fills 'entry' on a hit
+    bool probe(uint64_t key, TTEntry& entry) const;
+
+    // Store a search result, replacing the stalest / shallowest entry of the bucket
+    void store(uint64_t key, int score, int depth, TTEntryFlag flag);
+
+    // Permille of sampled entries written by the current search (UCI hashfull)
+    int hashfull() const;
+
+    // Write the table to 'path' / read it back (resizing to the saved size).
+    // Errors are reported on stderr and return false.
+    bool saveToFile(const std::string& path) const;
+    bool loadFromFile(const std::string& path);
+
+    // Attach to the named POSIX shared-memory table, creating it with 'megabytes' if it does
+    // not exist yet. An existing segment keeps the size it was created with. The last process
+    // to detach removes the segment. Errors are reported on stderr and return false.
+    bool attachShared(const std::string& name, size_t megabytes);
+
+    // Leave the shared table and fall back to a private table of 'megabytes'
+    void detachShared(size_t megabytes);
+
+    // Allow huge pages for private tables (UCI "Large Pages"); reallocates (clears) a private table
+    void setLargePages(bool allowed);
+    TTPageMode pages() const { return pageMode; }
+
+    bool isShared() const { return sharedHeader != nullptr; }
+    size_t sizeMB() const { return bucketCount * sizeof(TTBucket) / (1024 * 1024); }
+};
+
+// Global transposition table instance
+extern TranspositionTable transpositionTable;
+
+#endif // TT_H
@@ -2,12 +2,16 @@
 #define TYPES_H
 
 #include <string>
-#include <map>
 #include <utility>
+#include <cstdint>
+#include <new>
 #include "constants.h"
 
 struct BoardState; // Forward declaration
 
+// Side, as used by colour-templated code; also the index of BoardState::occupancy
+enum Color { WHITE, BLACK };
+
 struct Move {
     int fromRow, fromCol;
     int toRow, toCol;
@@ -39,6 +43,38 @@ struct Move {
     bool isCapture(const BoardState& state) const;
 };
 
+// Fixed-capacity move list, so that move generation and the search never allocate.
+// Moves are constructed in place; only the first size() slots hold moves.
+struct MoveList {
+    MoveList() : count(0) {}
+
+    template <typename... Args> void emplace_back(Args&&... args) { new (&storage[count++]) Move(std::forward<Args>(args)...); }
+    void push_back(const Move& move) { new (&storage[count++]) Move(move); }
+    void clear() { count = 0; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    void resize(int newSize) { count = newSize; } // Shrink only
+
+    Move* begin() { return reinterpret_cast<Move*>(storage); }
+    Move* end() { return begin() + count; }
+    const Move* begin() const { return reinterpret_cast<const Move*>(storage); }
+    const Move* end() const { return begin() + count; }
+    Move& operator[](int i) { return begin()[i]; }
+    const Move& operator[](int i) const { return begin()[i]; }
+
+private:
+    struct alignas(Move) Slot { unsigned char bytes[sizeof(Move)]; };
+    Slot storage[MAX_MOVES];
+    int count;
+};
+
+// A piece placed on or removed from a square by the last move (NNUE accumulator updates)
+struct DirtyPiece {
+    int8_t piece;  // pieceIndex
+    int8_t square; // row * 8 + col
+    bool added;
+};
+
 struct BoardState {
     char board[8][8];
     bool whiteToMove;
@@ -47,15 +83,20 @@ struct BoardState {
     std::pair<int, int> enPassantTarget;
     int halfmoveClock;
     int fullmoveNumber;
-    std::map<std::string, int> positionCounts;
-    std::string currentFenKey;
+    uint64_t hashKey; // Zobrist key of the position (board, side, castling, en passant)
+    uint64_t pawnKey; // Zobrist key of the pawns only (pawn hash table)
+    uint64_t materialKey; // Piece counts (see materialKeyUnit), indexes the material table
+    uint64_t pieceBB[12];  // Bitboard per piece index (square = row * 8 + col, see bitboard.h)
+    uint64_t occupancy[2]; // All pieces of a side, [0] white, [1] black
+    int psqMg, psqEg;  // Material + piece-square score from white's perspective, middlegame / endgame
+    int phase;         // Game phase: sum of phase_weights of the pieces on the board (0 = bare kings)
+    uint64_t parentKey;        // hashKey before the last move, 0 if the position was set up from scratch
+    DirtyPiece dirtyPieces[4]; // Pieces changed by the last move
+    int dirtyCount;
 
     BoardState();
     void reset();
-    std::string getPositionKey() const;
-    void addCurrentPositionToHistory();
     void parseFen(const std::string& fenStr);
-    void updateFenKey();
 };
 
 #endif // TYPES_H
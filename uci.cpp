@@ -3,17 +3,59 @@
 #include "movegen.h"
 #include "board.h"
 #include "book.h"
+#include "evaluation.h"
+#include "nnue.h"
+#include "bitbase.h"
 #include "constants.h"
+#include "allocation.h"
+#include "profile.h"
 #include <iostream>
 #include <vector>
 #include <chrono>
 #include <limits>
 #include <cctype>
+#include <cstdlib>
+#include <algorithm>
 
 // Global board state and RNG
 BoardState currentBoard;
 std::mt19937 global_rng;
 
+// Last position command applied to currentBoard. GUIs resend the whole game before every
+// move, so a command that only appends moves to it is applied incrementally.
+static std::string lastPositionBase; // "startpos" or the FEN, empty if currentBoard was reset
+static std::vector<std::string> lastPositionMoves;
+
+// Hash file used by savehash / loadhash (UCI option "Hash File")
+static std::string hashFilePath;
+
+// Opening book file (UCI option "BookFile"); empty disables the book
+static std::string bookFilePath = DEFAULT_BOOK_FILE;
+
+// Requested TT size and shared-memory table settings (UCI options "Hash", "Shared Hash", "Shared Hash Name")
+static size_t hashSizeMB = DEFAULT_TT_SIZE_MB;
+static bool useSharedHash = false;
+static std::string sharedHashName = DEFAULT_SHARED_TT_NAME;
+
+// Attach to the shared table, reporting the outcome; falls back to a private table on failure
+static void attachSharedHash() {
+    if (transpositionTable.attachShared(sharedHashName, hashSizeMB)) {
+        std::cout << "info string Attached to shared hash " << sharedHashName << " (" << transpositionTable.sizeMB() << " MB)" << std::endl;
+    } else {
+        useSharedHash = false;
+        std::cout << "info string Could not attach to shared hash " << sharedHashName << ", using a private table" << std::endl;
+    }
+}
+
+// Report the table size and whether it is backed by huge pages (UCI option "Large Pages")
+static void reportHashPages() {
+    const char* pages = "no";
+    if (transpositionTable.isShared()) pages = "no (shared hash)";
+    else if (transpositionTable.pages() == TT_PAGES_HUGETLB) pages = "yes (hugetlbfs)";
+    else if (transpositionTable.pages() == TT_PAGES_TRANSPARENT) pages = "yes (transparent huge pages)";
+    std::cout << "info string Hash " << transpositionTable.sizeMB() << " MB, large pages " << pages << std::endl;
+}
+
 // Apply move with full game logic (halfmove clock, position history, etc.)
 void master_apply_move(const Move& move) {
     char piece = currentBoard.board[move.fromRow][move.fromCol];
@@ -23,73 +65,185 @@ void master_apply_move(const Move& move) {
     apply_raw_move_to_board(currentBoard, move);
     if (isPawn || isCap) { currentBoard.halfmoveClock = 0; } else { currentBoard.halfmoveClock++; }
     if (!currentBoard.whiteToMove) { currentBoard.fullmoveNumber++; }
-    currentBoard.addCurrentPositionToHistory();
+    gameHistory.push_back(currentBoard.hashKey);
 }
 
 // Game end checks
-bool isCheckmate() { std::vector<Move> m; generateLegalMoves(currentBoard, m, false); return m.empty() && isKingInCheck(currentBoard, currentBoard.whiteToMove); }
-bool isStalemate() { std::vector<Move> m; generateLegalMoves(currentBoard, m, false); return m.empty() && !isKingInCheck(currentBoard, currentBoard.whiteToMove); }
-bool isThreefoldRepetition() { return currentBoard.positionCounts[currentBoard.currentFenKey] >= 3; }
+bool isCheckmate() { MoveList m; generateLegalMoves(currentBoard, m, false); return m.empty() && isKingInCheck(currentBoard, currentBoard.whiteToMove); }
+bool isStalemate() { MoveList m; generateLegalMoves(currentBoard, m, false); return m.empty() && !isKingInCheck(currentBoard, currentBoard.whiteToMove); }
+bool isThreefoldRepetition() { return repetitionCount(currentBoard.hashKey) >= 3; }
 bool isFiftyMoveDraw() { return currentBoard.halfmoveClock >= 100; }
 
-std::string checkGameEndStatus() {
-    if (isCheckmate()) return currentBoard.whiteToMove ? "0-1 {Black mates}" : "1-0 {White mates}";
-    if (isStalemate()) return "1/2-1/2 {Stalemate}";
-    if (isThreefoldRepetition()) return "1/2-1/2 {Draw by threefold repetition}";
-    if (isFiftyMoveDraw()) return "1/2-1/2 {Draw by fifty-move rule}";
+std::string gameEndStatus(const BoardState& state, const std::vector<uint64_t>& history) {
+    MoveList m;
+    generateLegalMoves(state, m, false);
+    bool inCheck = isKingInCheck(state, state.whiteToMove);
+    if (m.empty() && inCheck) return state.whiteToMove ? "0-1 {Black mates}" : "1-0 {White mates}";
+    if (m.empty()) return "1/2-1/2 {Stalemate}";
+    if (std::count(history.begin(), history.end(), state.hashKey) >= 3) return "1/2-1/2 {Draw by threefold repetition}";
+    if (state.halfmoveClock >= 100) return "1/2-1/2 {Draw by fifty-move rule}";
     return "";
 }
 
+std::string checkGameEndStatus() { return gameEndStatus(currentBoard, gameHistory); }
+
 // UCI handlers
 void handleUci() {
     // Load opening book if not already loaded
-    if (globalBook.size() == 0) {
-        globalBook.loadFromFile("opening_book.txt");
+    if (globalBook.size() == 0 && !bookFilePath.empty()) {
+        globalBook.loadFromFile(bookFilePath);
     }
-    std::cout << "id name Gotham\nid author Outhills\nuciok" << std::endl;
+    std::cout << "id name Gotham\nid author Outhills" << std::endl;
+    std::cout << "option name Hash type spin default " << DEFAULT_TT_SIZE_MB << " min 1 max " << MAX_TT_SIZE_MB << std::endl;
+    std::cout << "option name Clear Hash type button" << std::endl;
+    std::cout << "option name Hash File type string default <empty>" << std::endl;
+    std::cout << "option name Shared Hash type check default false" << std::endl;
+    std::cout << "option name Shared Hash Name type string default " << DEFAULT_SHARED_TT_NAME << std::endl;
+    std::cout << "option name Large Pages type check default true" << std::endl;
+    std::cout << "option name Use NNUE type check default false" << std::endl;
+    std::cout << "option name EvalFile type string default <empty>" << std::endl;
+    std::cout << "option name BitbaseFile type string default <empty>" << std::endl;
+    std::cout << "option name BookFile type string default " << DEFAULT_BOOK_FILE << std::endl;
+    reportHashPages();
+    std::cout << "uciok" << std::endl;
 }
 void handleIsReady() { std::cout << "readyok" << std::endl; }
 void handleUciNewGame() {
     currentBoard.reset();
-    transpositionTable.clear();
+    gameHistory.assign(1, currentBoard.hashKey);
+    lastPositionBase.clear();
+    // A shared table may be in use by other processes: age its entries instead of wiping them
+    if (transpositionTable.isShared()) transpositionTable.newSearch();
+    else transpositionTable.clear();
+    clearKillerMoves();
+    clearHistoryTable();
+}
+
+// setoption name <id> [value <x>]; option names may contain spaces
+void handleSetOption(std::istringstream& iss) {
+    std::string token, name, value;
+    iss >> token; // "name"
+    while (iss >> token && token != "value") { name += (name.empty() ? "" : " ") + token; }
+    while (iss >> token) { value += (value.empty() ? "" : " ") + token; }
+
+    if (name == "Hash") {
+        long long mb = std::atoll(value.c_str());
+        hashSizeMB = (size_t)std::max(1LL, std::min((long long)MAX_TT_SIZE_MB, mb));
+        if (transpositionTable.isShared()) {
+            std::cout << "info string Shared hash keeps its size of " << transpositionTable.sizeMB() << " MB" << std::endl;
+        } else {
+            transpositionTable.resize(hashSizeMB);
+            reportHashPages();
+        }
+    } else if (name == "Clear Hash") {
+        transpositionTable.clear();
+    } else if (name == "Hash File") {
+        hashFilePath = (value == "<empty>") ? "" : value;
+    } else if (name == "Shared Hash") {
+        bool enable = (value == "true");
+        if (enable && !transpositionTable.isShared()) { useSharedHash = true; attachSharedHash(); }
+        else if (!enable && transpositionTable.isShared()) transpositionTable.detachShared(hashSizeMB);
+        useSharedHash = enable && transpositionTable.isShared();
+    } else if (name == "Large Pages") {
+        transpositionTable.setLargePages(value == "true");
+        reportHashPages();
+    } else if (name == "Shared Hash Name") {
+        if (value.empty() || value == "<empty>") value = DEFAULT_SHARED_TT_NAME;
+        if (value[0] != '/') value = "/" + value;
+        sharedHashName = value;
+        if (useSharedHash) { transpositionTable.detachShared(hashSizeMB); attachSharedHash(); }
+    } else if (name == "EvalFile") {
+        if (value.empty() || value == "<empty>") return;
+        if (loadNnue(value)) {
+            std::cout << "info string NNUE loaded from " << value << " (" << nnueKernelName() << ")" << std::endl;
+            if (usingNnue()) setUseNnue(true); // Drop evals cached from the previous network
+        } else {
+            std::cout << "info string Failed to load NNUE from " << value
+                      << (nnueLoaded() ? ", keeping the previous network" : "") << std::endl;
+        }
+    } else if (name == "Use NNUE") {
+        bool enable = (value == "true");
+        if (enable && !nnueLoaded()) {
+            std::cout << "info string No NNUE network loaded (setoption name EvalFile value <path>)" << std::endl;
+        }
+        setUseNnue(enable);
+    } else if (name == "BookFile") {
+        if (value.empty() || value == "<empty>") {
+            bookFilePath.clear();
+            globalBook.clear();
+            std::cout << "info string Opening book disabled" << std::endl;
+        } else if (globalBook.loadFromFile(value)) {
+            bookFilePath = value;
+            std::cout << "info string Opening book loaded from " << value << " (" << globalBook.size() << " entries)" << std::endl;
+        } else {
+            std::cout << "info string Failed to load opening book from " << value << std::endl;
+        }
+    } else if (name == "BitbaseFile") {
+        if (value.empty() || value == "<empty>") return;
+        if (loadBitbaseFile(value)) {
+            std::cout << "info string Bitbases loaded from " << value << std::endl;
+            clearEvalCache();
+        } else {
+            std::cout << "info string Failed to load bitbases from " << value << std::endl;
+        }
+    }
+}
+
+// savehash [path] / loadhash [path]: write or restore the transposition table
+void handleSaveHash(std::istringstream& iss) {
+    std::string path;
+    if (!(iss >> path)) path = hashFilePath;
+    if (path.empty()) { std::cout << "info string No hash file set (setoption name Hash File value <path>)" << std::endl; return; }
+    if (transpositionTable.saveToFile(path)) std::cout << "info string Hash saved to " << path << std::endl;
+    else std::cout << "info string Failed to save hash to " << path << std::endl;
+}
+
+void handleLoadHash(std::istringstream& iss) {
+    std::string path;
+    if (!(iss >> path)) path = hashFilePath;
+    if (path.empty()) { std::cout << "info string No hash file set (setoption name Hash File value <path>)" << std::endl; return; }
+    if (transpositionTable.loadFromFile(path)) {
+        std::cout << "info string Hash loaded from " << path << " (" << transpositionTable.sizeMB() << " MB)" << std::endl;
+    } else {
+        std::cout << "info string Failed to load hash from " << path << std::endl;
+    }
 }
 
 void handlePosition(std::istringstream& iss) {
-    std::string token, fen_str; iss >> token;
+    std::string token, base; iss >> token;
     if (token == "startpos") {
-        currentBoard.reset();
-        transpositionTable.clear();
+        base = "startpos";
         iss >> token;
     } else if (token == "fen") {
-        while(iss >> token && token != "moves") { fen_str += token + " "; }
-        if (!fen_str.empty()) fen_str.pop_back();
-        currentBoard.parseFen(fen_str);
-        transpositionTable.clear();
+        while(iss >> token && token != "moves") { base += token + " "; }
+        if (!base.empty()) base.pop_back();
+    } else {
+        return;
     }
+    std::vector<std::string> moves;
     if (token == "moves") {
-        while (iss >> token) {
-            Move pMove; if (token.length() < 4) continue;
-            pMove.fromCol = token[0] - 'a'; pMove.fromRow = '8' - token[1];
-            pMove.toCol = token[2] - 'a'; pMove.toRow = '8' - token[3];
-            pMove.promotionPiece = EMPTY;
-            if (token.length() == 5) {
-                char promo = token[4]; char pieceColor = currentBoard.whiteToMove ? 'W' : 'B';
-                if (promo == 'q') pMove.promotionPiece = (pieceColor == 'W' ? W_QUEEN : B_QUEEN);
-                else if (promo == 'r') pMove.promotionPiece = (pieceColor == 'W' ? W_ROOK : B_ROOK);
-                else if (promo == 'b') pMove.promotionPiece = (pieceColor == 'W' ? W_BISHOP : B_BISHOP);
-                else if (promo == 'n') pMove.promotionPiece = (pieceColor == 'W' ? W_KNIGHT : B_KNIGHT);
-            }
-            std::vector<Move> legal_moves; generateLegalMoves(currentBoard, legal_moves, false);
-            Move moveToApply; bool found = false;
-            for (const auto& legal_m : legal_moves) {
-                if (legal_m.fromRow == pMove.fromRow && legal_m.fromCol == pMove.fromCol &&
-                    legal_m.toRow == pMove.toRow && legal_m.toCol == pMove.toCol &&
-                    legal_m.promotionPiece == pMove.promotionPiece ) {
-                    moveToApply = legal_m; found = true; break;
-                }
-            }
-            if (found) { master_apply_move(moveToApply); } else { break; }
-        }
+        while (iss >> token) moves.push_back(token);
+    }
+
+    // Reuse the current board if this command extends the previous move list
+    size_t firstNew = 0;
+    bool extendsPrevious = !lastPositionBase.empty() && base == lastPositionBase &&
+                           moves.size() >= lastPositionMoves.size() &&
+                           std::equal(lastPositionMoves.begin(), lastPositionMoves.end(), moves.begin());
+    if (extendsPrevious) {
+        firstNew = lastPositionMoves.size();
+    } else {
+        if (base == "startpos") currentBoard.reset(); else currentBoard.parseFen(base);
+        gameHistory.assign(1, currentBoard.hashKey);
+        lastPositionMoves.clear();
+    }
+    lastPositionBase = base;
+
+    for (size_t i = firstNew; i < moves.size(); ++i) {
+        Move moveToApply;
+        if (!parseUciMove(currentBoard, moves[i], moveToApply)) break;
+        master_apply_move(moveToApply);
+        lastPositionMoves.push_back(moves[i]);
     }
 }
 
@@ -98,6 +252,8 @@ void handleGo(std::istringstream& iss) {
     long long wtime_ms = -1, btime_ms = -1, winc_ms = 0, binc_ms = 0;
     int movestogo = 0;
     long long movetime_ms = -1;
+    long long node_budget = 0;
+    int max_depth = MAX_SEARCH_PLY;
 
     while(iss >> token) {
         if (token == "wtime") iss >> wtime_ms;
@@ -106,7 +262,11 @@ void handleGo(std::istringstream& iss) {
         else if (token == "binc") iss >> binc_ms;
         else if (token == "movestogo") iss >> movestogo;
         else if (token == "movetime") iss >> movetime_ms;
+        else if (token == "nodes") iss >> node_budget;
+        else if (token == "depth") iss >> max_depth;
     }
+    max_depth = std::max(1, std::min(max_depth, MAX_SEARCH_PLY));
+    bool fixedLimit = node_budget > 0 || max_depth < MAX_SEARCH_PLY;
 
     long long allocated_ms;
     long long time_buffer_ms = 100;
@@ -121,6 +281,9 @@ void handleGo(std::istringstream& iss) {
              allocated_ms = (my_time / moves_remaining) + my_inc - time_buffer_ms;
              allocated_ms = std::min(allocated_ms, my_time / 2 - time_buffer_ms);
              allocated_ms = std::max(10LL, allocated_ms);
+        } else if (fixedLimit) {
+            // go nodes / go depth without a clock: only that limit applies
+            allocated_ms = 24LL * 3600 * 1000;
         } else {
             allocated_ms = 2000 - time_buffer_ms;
         }
@@ -131,12 +294,17 @@ void handleGo(std::istringstream& iss) {
     auto startTime = std::chrono::steady_clock::now();
     time_is_up.store(false, std::memory_order_relaxed);
     nodes_searched.store(0, std::memory_order_relaxed);
+    node_limit = node_budget > 0 ? (uint64_t)node_budget : 0;
+
+    // Keep the transposition table from earlier moves; new entries get a newer generation
+    transpositionTable.newSearch();
 
-    // Clear killer moves and history table for new search
+    // Killers are ply-relative and start fresh; history tables are aged so they carry over
     clearKillerMoves();
-    clearHistoryTable();
+    ageHistoryTables();
+    resetEvalCacheStats();
 
-    std::vector<Move> legalEngineMoves;
+    MoveList legalEngineMoves;
     generateLegalMoves(currentBoard, legalEngineMoves, false);
     if (legalEngineMoves.empty()) { std::cout << "bestmove 0000" << std::endl; return; }
 
@@ -154,60 +322,23 @@ void handleGo(std::istringstream& iss) {
     Move bestMoveThisIteration = legalEngineMoves[0];
     int bestEvalOverall = std::numeric_limits<int>::min();
 
-    bool isEngineWhite = currentBoard.whiteToMove;
+
+    // Heap allocations inside the search (counted in TRACK_ALLOCATIONS builds)
+    uint64_t searchAllocations = 0;
+    if (profilingEnabled) resetProfile();
 
     // Iterative Deepening Loop with Aspiration Windows
-    for (int currentDepth = 1; currentDepth <= MAX_SEARCH_PLY; ++currentDepth) {
+    for (int currentDepth = 1; currentDepth <= max_depth; ++currentDepth) {
         auto iterationStartTime = std::chrono::steady_clock::now();
-        int currentIterBestEval = std::numeric_limits<int>::min();
-        std::vector<Move> candidateBestMovesThisIteration;
+        MoveList candidateBestMovesThisIteration;
 
         uint64_t nodes_at_start_of_iter = nodes_searched.load(std::memory_order_relaxed);
 
-        // Aspiration windows for depths >= 3
-        int alpha = std::numeric_limits<int>::min();
-        int beta = std::numeric_limits<int>::max();
-        if (currentDepth >= ASPIRATION_MIN_DEPTH && bestEvalOverall != std::numeric_limits<int>::min()) {
-            alpha = bestEvalOverall - ASPIRATION_WINDOW;
-            beta = bestEvalOverall + ASPIRATION_WINDOW;
-        }
-
-        for (const auto& engineMove : legalEngineMoves) {
-            BoardState boardAfterEngineMove = currentBoard;
-            apply_raw_move_to_board(boardAfterEngineMove, engineMove);
-            int evalFromWhitePerspective = alphaBetaSearch(boardAfterEngineMove, currentDepth - 1,
-                                                           alpha, beta,
-                                                           !isEngineWhite,
-                                                           startTime, timeLimit, 1, true);
-
-            if (time_is_up.load(std::memory_order_relaxed)) break;
-
-            // Re-search with full window if we fall outside aspiration window
-            if ((evalFromWhitePerspective <= alpha || evalFromWhitePerspective >= beta) && currentDepth >= ASPIRATION_MIN_DEPTH) {
-                evalFromWhitePerspective = alphaBetaSearch(boardAfterEngineMove, currentDepth - 1,
-                                                           std::numeric_limits<int>::min(),
-                                                           std::numeric_limits<int>::max(),
-                                                           !isEngineWhite,
-                                                           startTime, timeLimit, 1, true);
-            }
-
-            if (time_is_up.load(std::memory_order_relaxed)) break;
-
-            int currentMoveScoreForEngine;
-            if (isEngineWhite) {
-                currentMoveScoreForEngine = evalFromWhitePerspective;
-            } else {
-                currentMoveScoreForEngine = -evalFromWhitePerspective;
-            }
-
-            if (currentMoveScoreForEngine > currentIterBestEval) {
-                currentIterBestEval = currentMoveScoreForEngine;
-                candidateBestMovesThisIteration.clear();
-                candidateBestMovesThisIteration.push_back(engineMove);
-            } else if (currentMoveScoreForEngine == currentIterBestEval) {
-                candidateBestMovesThisIteration.push_back(engineMove);
-            }
-        }
+        // Aspiration windows for depths >= ASPIRATION_MIN_DEPTH around the last iteration's score
+        uint64_t allocationsBefore = allocationCount();
+        int currentIterBestEval = searchRoot(currentBoard, legalEngineMoves, currentDepth, bestEvalOverall,
+                                             startTime, timeLimit, candidateBestMovesThisIteration);
+        searchAllocations += allocationCount() - allocationsBefore;
 
         if (time_is_up.load(std::memory_order_relaxed)) { break; }
 
@@ -238,6 +369,7 @@ void handleGo(std::istringstream& iss) {
                       << " time " << iterationDuration.count()
                       << " nodes " << nodes_this_iter
                       << " nps " << nps
+                      << " hashfull " << transpositionTable.hashfull()
                       << " pv " << bestMoveOverall.toUci() << std::endl;
 
         } else { break; }
@@ -247,5 +379,15 @@ void handleGo(std::istringstream& iss) {
 
     } // End Iterative Deepening Loop
 
+    EvalCacheStats evalStats = getEvalCacheStats();
+    if (evalStats.probes > 0) {
+        std::cout << "info string Eval cache hits " << evalStats.hits << " of " << evalStats.probes
+                  << " (" << (evalStats.hits * 100 / evalStats.probes) << "%), lazy exits " << evalStats.lazyExits << std::endl;
+    }
+    if (ALLOCATION_TRACKING) {
+        std::cout << "info string Heap allocations during search " << searchAllocations << std::endl;
+    }
+    if (profilingEnabled) printProfile("info string ");
+
     std::cout << "bestmove " << bestMoveOverall.toUci() << std::endl;
 }
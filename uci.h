@@ -3,6 +3,8 @@
 
 #include "types.h"
 #include <sstream>
+#include <string>
+#include <vector>
 #include <random>
 
 // Global board state and RNG
@@ -13,6 +15,9 @@ extern std::mt19937 global_rng;
 void handleUci();
 void handleIsReady();
 void handleUciNewGame();
+void handleSetOption(std::istringstream& iss);
+void handleSaveHash(std::istringstream& iss);
+void handleLoadHash(std::istringstream& iss);
 void handlePosition(std::istringstream& iss);
 void handleGo(std::istringstream& iss);
 
@@ -24,4 +29,8 @@ bool isThreefoldRepetition();
 bool isFiftyMoveDraw();
 std::string checkGameEndStatus();
 
+// Result ("1-0 {White mates}", ...) if the game is over in 'state', "" otherwise; 'history'
+// holds the keys of the game's positions (including 'state') for repetitions
+std::string gameEndStatus(const BoardState& state, const std::vector<uint64_t>& history);
+
 #endif // UCI_H